@@ -0,0 +1,189 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* A bump allocator for the short-lived strings of one search or one
+ * grid update. Everything is released at once by a reset, which keeps
+ * the chunks, so a query after the first allocates nothing unless it
+ * needs more room than any query before it. An arena must only be used
+ * by one thread at a time. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "applauncher-arena.h"
+
+
+#define ARENA_ALIGN (2 * sizeof (gpointer))
+
+typedef struct _ArenaChunk ArenaChunk;
+
+struct _ArenaChunk
+{
+	ArenaChunk *next;
+	gsize       size;
+	gsize       used;
+	/* data follows, aligned to ARENA_ALIGN */
+};
+
+struct _ApplauncherArena
+{
+	gsize       chunk_size;
+	ArenaChunk *chunks;   /* the one being filled first */
+};
+
+#define CHUNK_HEADER  ((sizeof (ArenaChunk) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define CHUNK_DATA(c) ((guint8 *)(c) + CHUNK_HEADER)
+
+
+
+static ArenaChunk *
+arena_chunk_new (gsize size)
+{
+	ArenaChunk *chunk = g_malloc (CHUNK_HEADER + size);
+
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+static void
+arena_chunks_free (ArenaChunk *chunk)
+{
+	while (chunk) {
+		ArenaChunk *next = chunk->next;
+		g_free (chunk);
+		chunk = next;
+	}
+}
+
+ApplauncherArena *
+applauncher_arena_new (gsize chunk_size)
+{
+	ApplauncherArena *arena = g_slice_new0 (ApplauncherArena);
+
+	arena->chunk_size = MAX (chunk_size, 256);
+
+	return arena;
+}
+
+void
+applauncher_arena_free (ApplauncherArena *arena)
+{
+	if (arena == NULL)
+		return;
+
+	arena_chunks_free (arena->chunks);
+
+	g_slice_free (ApplauncherArena, arena);
+}
+
+/* Forgets every allocation. A query that overflowed into several chunks
+ * gets them merged into one as large, so the next one fits at once. */
+void
+applauncher_arena_reset (ApplauncherArena *arena)
+{
+	ArenaChunk *chunk;
+	gsize total = 0;
+
+	g_return_if_fail (arena != NULL);
+
+	if (arena->chunks == NULL)
+		return;
+
+	if (arena->chunks->next == NULL) {
+		arena->chunks->used = 0;
+		return;
+	}
+
+	for (chunk = arena->chunks; chunk; chunk = chunk->next)
+		total += chunk->size;
+
+	arena_chunks_free (arena->chunks);
+
+	arena->chunk_size = MAX (arena->chunk_size, total);
+	arena->chunks = arena_chunk_new (arena->chunk_size);
+}
+
+gpointer
+applauncher_arena_alloc (ApplauncherArena *arena, gsize size)
+{
+	ArenaChunk *chunk;
+	gpointer mem;
+
+	g_return_val_if_fail (arena != NULL, NULL);
+
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	chunk = arena->chunks;
+	if (chunk == NULL || chunk->size - chunk->used < size) {
+		chunk = arena_chunk_new (MAX (arena->chunk_size, size));
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+	}
+
+	mem = CHUNK_DATA (chunk) + chunk->used;
+	chunk->used += size;
+
+	return mem;
+}
+
+gchar *
+applauncher_arena_strdup (ApplauncherArena *arena, const gchar *string)
+{
+	gsize len;
+	gchar *copy;
+
+	if (string == NULL)
+		return NULL;
+
+	len = strlen (string) + 1;
+	copy = applauncher_arena_alloc (arena, len);
+	memcpy (copy, string, len);
+
+	return copy;
+}
+
+gchar *
+applauncher_arena_strdup_printf (ApplauncherArena *arena, const gchar *format, ...)
+{
+	va_list args;
+	gchar *string;
+	gint len;
+
+	va_start (args, format);
+	len = vsnprintf (NULL, 0, format, args);
+	va_end (args);
+
+	if (len < 0)
+		return NULL;
+
+	string = applauncher_arena_alloc (arena, len + 1);
+
+	va_start (args, format);
+	vsnprintf (string, len + 1, format, args);
+	va_end (args);
+
+	return string;
+}
@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __APPLAUNCHER_ARENA_H__
+#define __APPLAUNCHER_ARENA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ApplauncherArena ApplauncherArena;
+
+ApplauncherArena *applauncher_arena_new    (gsize             chunk_size);
+
+void              applauncher_arena_free   (ApplauncherArena *arena);
+
+void              applauncher_arena_reset  (ApplauncherArena *arena);
+
+gpointer          applauncher_arena_alloc  (ApplauncherArena *arena,
+                                            gsize             size);
+
+gchar            *applauncher_arena_strdup (ApplauncherArena *arena,
+                                            const gchar      *string);
+
+gchar            *applauncher_arena_strdup_printf (ApplauncherArena *arena,
+                                                   const gchar      *format,
+                                                   ...) G_GNUC_PRINTF (2, 3);
+
+G_END_DECLS
+
+#endif /* !__APPLAUNCHER_ARENA_H__ */
@@ -0,0 +1,284 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Benchmark of the catalog hot paths, built by "make check" against
+ * the core library only, so it needs neither a panel nor a display,
+ * and run by "make bench". It builds synthetic menus of 100, 1000 and 10000
+ * applications in a temporary directory and prints the timings to
+ * standard error, so it never touches the user's real menu. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#ifdef HAVE_MALLOC_H
+#include <malloc.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gdesktopappinfo.h>
+
+#include <gmenu-tree.h>
+
+#include "applauncher-catalog.h"
+#include "applauncher-spawn.h"
+#include "applauncher-test-menu.h"
+
+
+#define BENCH_ROUNDS          (5)
+#define BENCH_PAGE_SIZE       (18)
+#define BENCH_BLACKLIST_SIZE  (10)
+#define BENCH_SPAWN_ROUNDS    (20)
+
+
+
+static void
+bench_print (guint n_apps, const gchar *what, gint64 usec)
+{
+	g_printerr ("applauncher-bench: apps=%-5u %-22s %8.3f ms\n", n_apps, what, usec / 1000.0);
+}
+
+/* resident set size in bytes, after handing freed memory back */
+static gint64
+bench_rss (void)
+{
+	FILE *fp;
+	long size, resident = 0;
+
+#if defined (HAVE_MALLOC_H) && defined (HAVE_MALLOC_TRIM)
+	malloc_trim (0);
+#endif
+
+	fp = fopen ("/proc/self/statm", "r");
+	if (!fp)
+		return -1;
+
+	if (fscanf (fp, "%ld %ld", &size, &resident) != 2)
+		resident = -1;
+	fclose (fp);
+
+	return resident < 0 ? -1 : (gint64)resident * sysconf (_SC_PAGESIZE);
+}
+
+static void
+bench_print_rss (guint n_apps, const gchar *what, gint64 before, gint64 after)
+{
+	if (before >= 0 && after >= 0)
+		g_printerr ("applauncher-bench: apps=%-5u %-22s %8.1f KiB\n", n_apps,
+		            what, (after - before) / 1024.0 * 1000 / n_apps);
+}
+
+/* What the launcher kept before the catalog: the loaded menu tree, with
+ * a GDesktopAppInfo for every entry. */
+static void
+bench_menu_tree_rss (const gchar *menu_file, guint n_apps)
+{
+	GMenuTree *tree;
+	gint64 rss_before = bench_rss ();
+
+	tree = gmenu_tree_new_for_path (menu_file, GMENU_TREE_FLAGS_SORT_DISPLAY_NAME);
+	if (gmenu_tree_load_sync (tree, NULL))
+		bench_print_rss (n_apps, "menu-tree-rss-per-1000", rss_before, bench_rss ());
+	g_object_unref (tree);
+}
+
+static void
+bench_catalog (ApplauncherCatalog *catalog, const gchar *dir, guint n_apps)
+{
+	guint i, r, len;
+	gint64 start;
+	GList *app_infos = NULL;
+	GArray *matches;
+	gchar *blacklist[BENCH_BLACKLIST_SIZE + 1];
+	const gchar *query = "bench-app-00042";
+
+	/* blacklist resolution, with patterns that never match to scan it
+	 * all; the files are outside XDG_DATA_DIRS, so each is known by its
+	 * file name, as the catalog does for exported applications */
+	for (i = 0; i < applauncher_catalog_get_n_entries (catalog); i++) {
+		gchar *path = g_build_filename (dir, "applications",
+		                                applauncher_catalog_get_id (catalog, i), NULL);
+		GDesktopAppInfo *dt_info = g_desktop_app_info_new_from_filename (path);
+
+		if (dt_info)
+			app_infos = g_list_prepend (app_infos, dt_info);
+		g_free (path);
+	}
+	app_infos = g_list_reverse (app_infos);
+
+	for (i = 0; i < BENCH_BLACKLIST_SIZE; i++)
+		blacklist[i] = g_strdup_printf ("no-such-application-%u", i);
+	blacklist[BENCH_BLACKLIST_SIZE] = NULL;
+
+	start = g_get_monotonic_time ();
+	GSList *resolved = applauncher_catalog_resolve_blacklist (blacklist, app_infos);
+	bench_print (n_apps, "blacklist-resolve", g_get_monotonic_time () - start);
+
+	g_slist_free_full (resolved, g_free);
+	for (i = 0; i < BENCH_BLACKLIST_SIZE; i++)
+		g_free (blacklist[i]);
+	g_list_free_full (app_infos, g_object_unref);
+
+	/* one query per length, as typed */
+	for (len = 0; len <= strlen (query); len++) {
+		gchar *text = g_strndup (query, len);
+		gchar *what = g_strdup_printf ("search-len-%02u", len);
+
+		start = g_get_monotonic_time ();
+		for (r = 0; r < BENCH_ROUNDS; r++) {
+			matches = applauncher_catalog_search (catalog, text, NULL);
+			g_array_unref (matches);
+		}
+		bench_print (n_apps, what, (g_get_monotonic_time () - start) / BENCH_ROUNDS);
+
+		g_free (what);
+		g_free (text);
+	}
+
+	/* pagination, fetching what update_grid() shows for every page */
+	matches = applauncher_catalog_search (catalog, "", NULL);
+	guint n_pages = applauncher_catalog_count_pages (matches->len, BENCH_PAGE_SIZE);
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < matches->len; i++) {
+		guint idx = g_array_index (matches, guint, i);
+
+		applauncher_catalog_get_icon (catalog, idx);
+		applauncher_catalog_get_name (catalog, idx);
+		applauncher_catalog_get_description (catalog, idx);
+	}
+	if (n_pages > 0)
+		bench_print (n_apps, "paginate-per-page", (g_get_monotonic_time () - start) / n_pages);
+
+	g_array_unref (matches);
+
+	/* switching category with some text typed, every category in turn */
+	matches = applauncher_catalog_search (catalog, "1", NULL);
+	GArray *filtered = g_array_sized_new (FALSE, FALSE, sizeof (guint), matches->len);
+	guint c, n_categories = applauncher_catalog_get_n_categories (catalog);
+
+	start = g_get_monotonic_time ();
+	for (c = 0; c < n_categories; c++) {
+		guint n_members;
+		const guint *members = applauncher_catalog_get_category_members (catalog, c, &n_members);
+
+		applauncher_catalog_intersect ((const guint *) matches->data, matches->len,
+		                               members, n_members, filtered);
+	}
+	if (n_categories > 0)
+		bench_print (n_apps, "category-switch", (g_get_monotonic_time () - start) / n_categories);
+
+	g_array_unref (filtered);
+	g_array_unref (matches);
+}
+
+/* launch-to-exec latency: both calls only return once the child has
+ * exec'd or failed to, so the time spent in them is what a click pays */
+static void
+bench_spawn (void)
+{
+	guint i, backend;
+	gint64 start, total;
+	gchar *argv[2] = { NULL, NULL };
+
+	argv[0] = g_find_program_in_path ("true");
+	if (!argv[0])
+		return;
+
+	for (backend = 0; backend < 2; backend++) {
+		total = 0;
+		for (i = 0; i < BENCH_SPAWN_ROUNDS; i++) {
+			GPid pid;
+			gboolean ret;
+
+			start = g_get_monotonic_time ();
+			if (backend == 0)
+				ret = g_spawn_async (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+				                     NULL, NULL, &pid, NULL);
+			else
+				ret = applauncher_spawn_async (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+				                               &pid, NULL);
+			total += g_get_monotonic_time () - start;
+
+			if (!ret)
+				break;
+
+			waitpid (pid, NULL, 0);
+			g_spawn_close_pid (pid);
+		}
+
+		if (i > 0)
+			g_printerr ("applauncher-bench: %-32s %8.3f ms\n",
+			            backend == 0 ? "spawn-g_spawn_async" : "spawn-applauncher_spawn_async",
+			            total / 1000.0 / i);
+	}
+
+	g_free (argv[0]);
+}
+
+int
+main (int argc, char **argv)
+{
+	guint i;
+	gint64 start;
+	const guint sizes[] = { 100, 1000, 10000 };
+
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		gchar *dir, *menu_file = NULL;
+		ApplauncherCatalog *catalog;
+
+		dir = g_dir_make_tmp ("applauncher-bench-XXXXXX", NULL);
+		if (!dir)
+			return 1;
+
+		if (applauncher_test_write_menu (dir, sizes[i], TRUE, &menu_file)) {
+			gint64 rss_before;
+
+			bench_menu_tree_rss (menu_file, sizes[i]);
+
+			rss_before = bench_rss ();
+
+			start = g_get_monotonic_time ();
+			catalog = applauncher_catalog_new (menu_file, NULL, NULL);
+			bench_print (sizes[i], "catalog-load", g_get_monotonic_time () - start);
+
+			/* what stays resident once the menu tree is gone */
+			bench_print_rss (sizes[i], "catalog-rss-per-1000", rss_before, bench_rss ());
+
+			bench_catalog (catalog, dir, sizes[i]);
+
+			applauncher_catalog_unref (catalog);
+		}
+
+		applauncher_test_remove_tree (dir);
+
+		g_free (menu_file);
+		g_free (dir);
+	}
+
+	bench_spawn ();
+
+	return 0;
+}
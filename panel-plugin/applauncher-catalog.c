@@ -0,0 +1,1233 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* The catalog is the list of applications shown by the launcher, read
+ * from the XDG applications menu and from the directories flatpak and
+ * snapd export desktop files to, together with an index of the strings
+ * the search matches against. It is immutable once built, so a reference
+ * can be handed to a worker thread to search it.
+ *
+ * Only the fields the launcher uses are kept, as one array per field,
+ * with the strings interned in a single GStringChunk. The menu tree and
+ * its GDesktopAppInfo objects, which hold every key and translation of
+ * every desktop file, are dropped once the catalog is built. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gdesktopappinfo.h>
+
+#include <gmenu-tree.h>
+
+#include "panel-glib.h"
+#include "applauncher-trace.h"
+#include "applauncher-catalog.h"
+
+
+struct _ApplauncherCatalog
+{
+	volatile gint           ref_count;
+
+	guint                   n_entries;
+
+	/* every string below is interned in here */
+	GStringChunk           *strings;
+
+	/* one element per entry, deduplicated, in menu order */
+	const gchar           **ids;
+	const gchar           **names;
+	const gchar           **descriptions;
+	GIcon                 **icons;
+	const gchar           **keys;   /* folded search text, see fold_append() */
+	ApplauncherLaunchPlan **plans;  /* or NULL if not launchable */
+
+	/* interned id to index + 1, for applauncher_catalog_find() */
+	GHashTable             *by_id;
+
+	/* the top-level directories of the menu, and for each the sorted
+	 * indexes of the entries under it, members[offsets[c]] up to
+	 * members[offsets[c + 1]] */
+	guint                   n_categories;
+	const gchar           **category_names;
+	GIcon                 **category_icons;
+	guint                  *category_offsets;
+	guint                  *category_members;
+};
+
+/* category of the entries found outside of any directory */
+#define NO_CATEGORY G_MAXUINT
+
+
+static GSList *get_all_applications_from_dir (GMenuTreeDirectory   *directory,
+                                              GSList               *list,
+                                              GSList               *blacklist,
+                                              GPtrArray            *categories,
+                                              GArray               *entry_categories,
+                                              guint                 category);
+
+static ApplauncherCatalog *default_catalog = NULL;
+static GSettings          *default_settings = NULL;
+static GAppInfoMonitor    *default_monitor = NULL;
+static gchar             **default_app_dirs = NULL;
+static GPtrArray          *default_dir_monitors = NULL;
+static guint               default_rebuild_id = 0;
+static guint               default_generation = 0;
+static gboolean            default_rebuilding = FALSE;
+
+/* A directory of desktop files read on a worker thread while the menu
+ * is loaded, see scan_thread(). */
+typedef struct
+{
+	const gchar *path;
+	GThread     *thread;
+	GPtrArray   *apps;   /* GDesktopAppInfo, by name */
+} DirScan;
+
+
+
+/* Returns every Name key of the desktop file, translations included,
+ * as a %NULL-terminated array allocated in @arena. */
+static gchar **
+desktop_get_names (GDesktopAppInfo *dt_info, ApplauncherArena *arena)
+{
+	const char *desktop;
+	gchar **names = NULL;
+	gsize n_names = 0;
+
+	desktop = g_desktop_app_info_get_filename (dt_info);
+	if (desktop) {
+		GKeyFile *keyfile = g_key_file_new ();
+
+		if (g_key_file_load_from_file (keyfile, desktop,
+					G_KEY_FILE_KEEP_TRANSLATIONS,
+					NULL)) {
+			gsize num_keys, i;
+			gchar **keys = g_key_file_get_keys (keyfile, "Desktop Entry", &num_keys, NULL);
+
+			names = applauncher_arena_alloc (arena, (num_keys + 1) * sizeof (gchar *));
+
+			for (i = 0; i < num_keys; i++) {
+				if (!g_str_has_prefix (keys[i], "Name"))
+					continue;
+
+				gchar *value = g_key_file_get_value (keyfile, "Desktop Entry", keys[i], NULL);
+				if (value)
+					names[n_names++] = applauncher_arena_strdup (arena, value);
+				g_free (value);
+			}
+			g_strfreev (keys);
+		}
+		g_key_file_free (keyfile);
+	}
+
+	if (names == NULL)
+		names = applauncher_arena_alloc (arena, sizeof (gchar *));
+	names[n_names] = NULL;
+
+	return names;
+}
+
+/* Desktop files read from outside of the XDG data directories have no
+ * id of their own; their file name stands for it, as it would if the
+ * directory were one of them. */
+static const gchar *
+app_info_get_id (GDesktopAppInfo *dt_info)
+{
+	const gchar *id, *filename;
+
+	id = g_app_info_get_id (G_APP_INFO (dt_info));
+	if (id)
+		return id;
+
+	filename = g_desktop_app_info_get_filename (dt_info);
+	if (!filename)
+		return NULL;
+
+	return strrchr (filename, G_DIR_SEPARATOR) ? strrchr (filename, G_DIR_SEPARATOR) + 1 : filename;
+}
+
+typedef struct
+{
+	GAppInfo  *app_info;
+	gchar    **names;   /* read on first use */
+} BlacklistCandidate;
+
+static const gchar *
+candidate_get_id (BlacklistCandidate *candidate)
+{
+	if (G_IS_DESKTOP_APP_INFO (candidate->app_info))
+		return app_info_get_id (G_DESKTOP_APP_INFO (candidate->app_info));
+
+	return g_app_info_get_id (candidate->app_info);
+}
+
+static gboolean
+candidate_has_name (BlacklistCandidate *candidate, const gchar *name, ApplauncherArena *arena)
+{
+	guint i;
+
+	if (candidate->names == NULL) {
+		if (G_IS_DESKTOP_APP_INFO (candidate->app_info)) {
+			candidate->names = desktop_get_names (G_DESKTOP_APP_INFO (candidate->app_info), arena);
+		} else {
+			candidate->names = applauncher_arena_alloc (arena, sizeof (gchar *));
+			candidate->names[0] = NULL;
+		}
+	}
+
+	for (i = 0; candidate->names[i] != NULL; i++) {
+		if (panel_g_utf8_strstrcase (candidate->names[i], name) != NULL)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gchar *
+find_desktop_by_id (BlacklistCandidate *candidates, guint n_candidates,
+                    const gchar *find_str, ApplauncherArena *arena)
+{
+	guint i;
+
+	if (!find_str || g_str_equal (find_str, ""))
+		return NULL;
+
+	for (i = 0; i < n_candidates; i++) {
+		const gchar *id = candidate_get_id (&candidates[i]);
+
+		if (!id)
+			continue;
+
+		if (g_str_equal (id, find_str))
+			return g_strdup (id);
+
+		if (candidate_has_name (&candidates[i], find_str, arena))
+			return g_strdup (id);
+	}
+
+	return NULL;
+}
+
+static gboolean
+is_blacklisted (const gchar *id, GSList *blacklist)
+{
+	GSList *l;
+
+	if (!id)
+		return FALSE;
+
+	for (l = blacklist; l; l = l->next) {
+		gchar *_id = (gchar *)l->data;
+		if (g_str_equal (_id, ""))
+			continue;
+
+		if (g_str_equal (_id, id))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+has_blacklist (GMenuTreeEntry *entry, GSList *blacklist)
+{
+	GDesktopAppInfo *dt_info;
+
+	if (!entry || !blacklist)
+		return FALSE;
+
+	dt_info = gmenu_tree_entry_get_app_info (entry);
+
+	return dt_info && is_blacklisted (g_app_info_get_id (G_APP_INFO (dt_info)), blacklist);
+}
+
+GSList *
+applauncher_catalog_resolve_blacklist (gchar **blacklist, GList *app_infos)
+{
+	guint i, n_candidates;
+	GList *l;
+	GSList *blacklist_apps = NULL;
+	BlacklistCandidate *candidates;
+	ApplauncherArena *arena;
+
+	if (!blacklist || !blacklist[0])
+		return NULL;
+
+	/* the names of each desktop file are read once, whatever the
+	 * number of patterns, and all dropped together at the end */
+	arena = applauncher_arena_new (64 * 1024);
+
+	candidates = applauncher_arena_alloc (arena, g_list_length (app_infos) * sizeof (BlacklistCandidate));
+	n_candidates = 0;
+	for (l = app_infos; l; l = l->next) {
+		if (!l->data)
+			continue;
+		candidates[n_candidates].app_info = G_APP_INFO (l->data);
+		candidates[n_candidates].names = NULL;
+		n_candidates++;
+	}
+
+	for (i = 0; blacklist[i]; i++) {
+		if (!g_str_equal (blacklist[i], "")) {
+			// find desktop file
+			gchar *desktop = find_desktop_by_id (candidates, n_candidates, blacklist[i], arena);
+			if (desktop) {
+				if (!g_slist_find_custom (blacklist_apps, desktop, (GCompareFunc) g_utf8_collate)) {
+					blacklist_apps = g_slist_append (blacklist_apps, desktop);
+				} else {
+					g_free (desktop);
+				}
+			}
+		}
+	}
+
+	applauncher_arena_free (arena);
+
+	return blacklist_apps;
+}
+
+GSList *
+applauncher_catalog_get_blacklist (void)
+{
+	GSettings *settings;
+	gchar **blacklist = NULL;
+	GList *all_apps = NULL;
+	GSList *blacklist_apps = NULL;
+
+	settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	blacklist = g_settings_get_strv (settings, "blacklist");
+	g_object_unref (settings);
+
+	all_apps = g_app_info_get_all ();
+
+	blacklist_apps = applauncher_catalog_resolve_blacklist (blacklist, all_apps);
+
+	g_list_free_full (all_apps, g_object_unref);
+	g_strfreev (blacklist);
+
+	return blacklist_apps;
+}
+
+/* Copied from gnome-panel-3.26.0/gnome-panel/menu.c:
+ * get_applications_menu () */
+static gchar *
+get_applications_menu (void)
+{
+	const gchar *xdg_menu_prefx = g_getenv ("XDG_MENU_PREFIX");
+
+	if (xdg_menu_prefx == NULL )
+		return g_strdup ("gnome-applications.menu");
+
+	if (strlen (xdg_menu_prefx) == 0)
+		return g_strdup ("gnome-applications.menu");
+
+	return g_strdup_printf ("%sapplications.menu", xdg_menu_prefx);
+}
+
+
+/* Copied from gnome-panel-3.26.0/gnome-panel/panel-run-dialog.c:
+ * get_all_applications_from_alias () */
+static GSList *
+get_all_applications_from_alias (GMenuTreeAlias   *alias,
+                                 GSList           *list,
+                                 GSList           *blacklist,
+                                 GPtrArray        *categories,
+                                 GArray           *entry_categories,
+                                 guint             category)
+{
+	switch (gmenu_tree_alias_get_aliased_item_type (alias))
+	{
+		case GMENU_TREE_ITEM_ENTRY: {
+			GMenuTreeEntry *entry = gmenu_tree_alias_get_aliased_entry (alias);
+			if (!has_blacklist (entry, blacklist)) {
+				/* pass on the reference */
+				list = g_slist_append (list, entry);
+				g_array_append_val (entry_categories, category);
+			} else {
+				gmenu_tree_item_unref (entry);
+			}
+			break;
+		}
+
+		case GMENU_TREE_ITEM_DIRECTORY: {
+			GMenuTreeDirectory *directory = gmenu_tree_alias_get_aliased_directory (alias);
+			list = get_all_applications_from_dir (directory, list, blacklist,
+			                                      categories, entry_categories, category);
+			gmenu_tree_item_unref (directory);
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	return list;
+}
+
+/* Copied from gnome-panel-3.26.0/gnome-panel/panel-run-dialog.c:
+ * get_all_applications_from_dir ()
+ *
+ * Also notes, in @entry_categories, under which top-level directory of
+ * the menu each entry was found; each of those directories is added to
+ * @categories the first time it is entered, while @category is still
+ * NO_CATEGORY. */
+static GSList *
+get_all_applications_from_dir (GMenuTreeDirectory  *directory,
+                               GSList              *list,
+                               GSList              *blacklist,
+                               GPtrArray           *categories,
+                               GArray              *entry_categories,
+                               guint                category)
+{
+	GMenuTreeIter *iter;
+	GMenuTreeItemType next_type;
+
+	iter = gmenu_tree_directory_iter (directory);
+
+	while ((next_type = gmenu_tree_iter_next (iter)) != GMENU_TREE_ITEM_INVALID) {
+		switch (next_type) {
+			case GMENU_TREE_ITEM_ENTRY: {
+				GMenuTreeEntry *entry = gmenu_tree_iter_get_entry (iter);
+				if (!has_blacklist (entry, blacklist)) {
+					list = g_slist_append (list, entry);
+					g_array_append_val (entry_categories, category);
+				} else {
+					gmenu_tree_item_unref (entry);
+				}
+				break;
+			}
+
+			case GMENU_TREE_ITEM_DIRECTORY: {
+				GMenuTreeDirectory *dir = gmenu_tree_iter_get_directory (iter);
+				guint dir_category = category;
+
+				if (category == NO_CATEGORY) {
+					dir_category = categories->len;
+					g_ptr_array_add (categories, gmenu_tree_item_ref (dir));
+				}
+
+				list = get_all_applications_from_dir (dir, list, blacklist,
+				                                      categories, entry_categories, dir_category);
+				gmenu_tree_item_unref (dir);
+				break;
+			}
+
+			case GMENU_TREE_ITEM_ALIAS: {
+				GMenuTreeAlias *alias = gmenu_tree_iter_get_alias (iter);
+				list = get_all_applications_from_alias (alias, list, blacklist,
+				                                        categories, entry_categories, category);
+				gmenu_tree_item_unref (alias);
+				break;
+			}
+
+			default:
+			break;
+		}
+	}
+
+	gmenu_tree_iter_unref (iter);
+
+	return list;
+}
+
+/* Copied from gnome-panel-3.26.0/gnome-panel/panel-run-dialog.c:
+ * get_all_applications () */
+static GSList *
+get_all_applications (GMenuTree *tree, GSList *blacklist,
+                      GPtrArray *categories, GArray *entry_categories)
+{
+	GMenuTreeDirectory *root;
+	GSList             *list = NULL;
+
+	if (!gmenu_tree_load_sync (tree, NULL))
+		return NULL;
+
+	root = gmenu_tree_get_root_directory (tree);
+
+	list = get_all_applications_from_dir (root, NULL, blacklist,
+	                                      categories, entry_categories, NO_CATEGORY);
+
+	gmenu_tree_item_unref (root);
+
+	return list;
+}
+
+static gint
+compare_app_name (gconstpointer a, gconstpointer b)
+{
+	GAppInfo *app_a = *(GAppInfo **) a;
+	GAppInfo *app_b = *(GAppInfo **) b;
+
+	return g_utf8_collate (g_app_info_get_name (app_a), g_app_info_get_name (app_b));
+}
+
+/* Runs in a worker thread: reads every desktop file of the directory
+ * that would be shown, sorted by name like the menu. */
+static gpointer
+scan_thread (gpointer data)
+{
+	DirScan *scan = data;
+	const gchar *name;
+	GDir *dir;
+
+	dir = g_dir_open (scan->path, 0, NULL);
+	if (!dir)
+		return NULL;
+
+	while ((name = g_dir_read_name (dir)) != NULL) {
+		GDesktopAppInfo *dt_info;
+		gchar *filename;
+
+		if (!g_str_has_suffix (name, ".desktop"))
+			continue;
+
+		filename = g_build_filename (scan->path, name, NULL);
+		dt_info = g_desktop_app_info_new_from_filename (filename);
+		g_free (filename);
+
+		if (!dt_info)
+			continue;
+
+		if (!g_app_info_should_show (G_APP_INFO (dt_info))) {
+			g_object_unref (dt_info);
+			continue;
+		}
+
+		g_ptr_array_add (scan->apps, dt_info);
+	}
+	g_dir_close (dir);
+
+	g_ptr_array_sort (scan->apps, compare_app_name);
+
+	return NULL;
+}
+
+/* The directories flatpak and snapd export desktop files to, which the
+ * applications menu only lists if they are in XDG_DATA_DIRS. */
+static gchar **
+get_export_dirs (void)
+{
+	gchar **dirs = g_new0 (gchar *, 4);
+
+	dirs[0] = g_build_filename (g_get_user_data_dir (), "flatpak", "exports", "share", "applications", NULL);
+	dirs[1] = g_strdup ("/var/lib/flatpak/exports/share/applications");
+	dirs[2] = g_strdup ("/var/lib/snapd/desktop/applications");
+
+	return dirs;
+}
+
+/* Lowercases @text a character at a time, like panel_g_utf8_strstrcase()
+ * does while matching, so that a plain strstr() on the results gives
+ * the same answer. */
+static void
+fold_append (GString *string, const gchar *text)
+{
+	const gchar *p;
+
+	if (!text || !g_utf8_validate (text, -1, NULL))
+		return;
+
+	for (p = text; *p != '\0'; p = g_utf8_next_char (p))
+		g_string_append_unichar (string, g_unichar_tolower (g_utf8_get_char (p)));
+
+	/* never part of a query, so matches cannot span two strings */
+	g_string_append_c (string, '\n');
+}
+
+static const gchar *
+intern (ApplauncherCatalog *catalog, const gchar *string)
+{
+	return string ? g_string_chunk_insert_const (catalog->strings, string) : NULL;
+}
+
+static void
+catalog_add_entry (ApplauncherCatalog *catalog, guint i, GDesktopAppInfo *dt_info,
+                   ApplauncherArena *arena)
+{
+	GAppInfo *app_info = G_APP_INFO (dt_info);
+	GString *key;
+	gchar **names;
+	guint n;
+
+	catalog->ids[i] = intern (catalog, app_info_get_id (dt_info));
+	catalog->names[i] = intern (catalog, g_app_info_get_name (app_info));
+	catalog->descriptions[i] = intern (catalog, g_app_info_get_description (app_info));
+
+	if (g_app_info_get_icon (app_info))
+		catalog->icons[i] = g_object_ref (g_app_info_get_icon (app_info));
+
+	/* the executable and every translation of the name */
+	key = g_string_new (NULL);
+	fold_append (key, g_app_info_get_executable (app_info));
+	names = desktop_get_names (dt_info, arena);
+	for (n = 0; names[n] != NULL; n++)
+		fold_append (key, names[n]);
+	applauncher_arena_reset (arena);
+
+	catalog->keys[i] = intern (catalog, key->str);
+	g_string_free (key, TRUE);
+}
+
+static gint
+compare_index (gconstpointer a, gconstpointer b)
+{
+	guint ia = *(const guint *) a;
+	guint ib = *(const guint *) b;
+
+	return (ia > ib) - (ia < ib);
+}
+
+/* Keeps the non-empty categories, flattening their sorted, duplicate
+ * free member lists into one array. Frees @members' arrays. */
+/* Flags the plans whose binary another plan runs too, which only the
+ * window's WM_CLASS can then tell apart. */
+static void
+catalog_mark_shared_binaries (ApplauncherCatalog *catalog)
+{
+	GHashTable *by_binary;
+	guint i;
+
+	by_binary = g_hash_table_new (g_str_hash, g_str_equal);
+
+	for (i = 0; i < catalog->n_entries; i++) {
+		ApplauncherLaunchPlan *plan = catalog->plans[i], *other;
+
+		if (!plan || !plan->binary)
+			continue;
+
+		other = g_hash_table_lookup (by_binary, plan->binary);
+		if (other)
+			other->shares_binary = plan->shares_binary = TRUE;
+		else
+			g_hash_table_insert (by_binary, plan->binary, plan);
+	}
+
+	g_hash_table_destroy (by_binary);
+}
+
+static void
+catalog_add_categories (ApplauncherCatalog *catalog, GPtrArray *categories, GArray **members)
+{
+	guint c, i, n_members = 0;
+
+	catalog->category_names = g_new0 (const gchar *, categories->len);
+	catalog->category_icons = g_new0 (GIcon *, categories->len);
+	catalog->category_offsets = g_new0 (guint, categories->len + 1);
+
+	for (c = 0; c < categories->len; c++) {
+		g_array_sort (members[c], compare_index);
+		n_members += members[c]->len;
+	}
+	catalog->category_members = g_new (guint, n_members);
+
+	n_members = 0;
+	for (c = 0; c < categories->len; c++) {
+		GMenuTreeDirectory *dir = g_ptr_array_index (categories, c);
+		GArray *list = members[c];
+		guint n = catalog->n_categories;
+
+		if (list->len > 0) {
+			catalog->category_names[n] = intern (catalog, gmenu_tree_directory_get_name (dir));
+			if (gmenu_tree_directory_get_icon (dir))
+				catalog->category_icons[n] = g_object_ref (gmenu_tree_directory_get_icon (dir));
+
+			catalog->category_offsets[n] = n_members;
+			for (i = 0; i < list->len; i++) {
+				guint index = g_array_index (list, guint, i);
+
+				if (i > 0 && index == g_array_index (list, guint, i - 1))
+					continue;
+				catalog->category_members[n_members++] = index;
+			}
+			catalog->n_categories++;
+		}
+
+		g_array_free (list, TRUE);
+	}
+	catalog->category_offsets[catalog->n_categories] = n_members;
+}
+
+/* Adds @dt_info to @entries unless an application of the same id is
+ * there already, and notes it under @category. Returns FALSE if it was
+ * not added, @dt_info is then left to the caller. */
+static gboolean
+merge_entry (GPtrArray *entries, GHashTable *seen, GArray **members,
+             GDesktopAppInfo *dt_info, guint category)
+{
+	const gchar *id = app_info_get_id (dt_info);
+	guint index = id ? GPOINTER_TO_UINT (g_hash_table_lookup (seen, id)) : 0;
+	gboolean added = FALSE;
+
+	if (index == 0) {
+		g_ptr_array_add (entries, dt_info);
+		index = entries->len;
+		if (id)
+			g_hash_table_insert (seen, (gpointer) id, GUINT_TO_POINTER (index));
+		added = TRUE;
+	}
+
+	if (category != NO_CATEGORY) {
+		index--;
+		g_array_append_val (members[category], index);
+	}
+
+	return added;
+}
+
+/* Builds the catalog of @menu_file, or of the user's applications menu
+ * if it is %NULL, together with the desktop files of @app_dirs, which
+ * are read in parallel with the menu; an application found in both is
+ * shown once, as the menu has it. */
+ApplauncherCatalog *
+applauncher_catalog_new (const gchar         *menu_file,
+                         const gchar * const *app_dirs,
+                         GSList              *blacklist)
+{
+	guint i, j, n_scans;
+	gint64 trace;
+	GMenuTree *tree;
+	GPtrArray *entries, *categories;
+	GArray *entry_categories, **members;
+	GHashTable *seen;
+	GSList *l = NULL, *all_apps = NULL;
+	ApplauncherCatalog *catalog;
+	ApplauncherArena *arena;
+	DirScan *scans;
+
+	n_scans = app_dirs ? g_strv_length ((gchar **) app_dirs) : 0;
+	scans = g_new0 (DirScan, n_scans);
+	for (i = 0; i < n_scans; i++) {
+		scans[i].path = app_dirs[i];
+		scans[i].apps = g_ptr_array_new ();
+		scans[i].thread = g_thread_new ("applauncher-scan", scan_thread, &scans[i]);
+	}
+
+	if (menu_file && g_path_is_absolute (menu_file)) {
+		tree = gmenu_tree_new_for_path (menu_file, GMENU_TREE_FLAGS_SORT_DISPLAY_NAME);
+	} else {
+		gchar *applications_menu = menu_file ? g_strdup (menu_file) : get_applications_menu ();
+		tree = gmenu_tree_new (applications_menu, GMENU_TREE_FLAGS_SORT_DISPLAY_NAME);
+		g_free (applications_menu);
+	}
+
+	categories = g_ptr_array_new_with_free_func ((GDestroyNotify)gmenu_tree_item_unref);
+	entry_categories = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	all_apps = get_all_applications (tree, blacklist, categories, entry_categories);
+
+	members = g_new (GArray *, categories->len);
+	for (i = 0; i < categories->len; i++)
+		members[i] = g_array_new (FALSE, FALSE, sizeof (guint));
+
+	/* an application listed in several directories is shown once, but
+	 * belongs to each of their categories; maps id to index + 1 */
+	seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+	entries = g_ptr_array_new_with_free_func (g_object_unref);
+	for (l = all_apps, i = 0; l; l = l->next, i++) {
+		GDesktopAppInfo *dt_info = gmenu_tree_entry_get_app_info (l->data);
+
+		if (dt_info && merge_entry (entries, seen, members, dt_info,
+		                            g_array_index (entry_categories, guint, i)))
+			g_object_ref (dt_info);
+
+		gmenu_tree_item_unref (l->data);
+	}
+	g_slist_free (all_apps);
+	g_array_free (entry_categories, TRUE);
+
+	/* the exported applications follow those of the menu, in no
+	 * category of their own */
+	trace = applauncher_trace_begin ();
+	for (i = 0; i < n_scans; i++) {
+		g_thread_join (scans[i].thread);
+
+		for (j = 0; j < scans[i].apps->len; j++) {
+			GDesktopAppInfo *dt_info = g_ptr_array_index (scans[i].apps, j);
+
+			if (is_blacklisted (app_info_get_id (dt_info), blacklist) ||
+			    !merge_entry (entries, seen, members, dt_info, NO_CATEGORY))
+				g_object_unref (dt_info);
+		}
+		g_ptr_array_free (scans[i].apps, TRUE);
+	}
+	g_free (scans);
+	applauncher_trace_end (trace, "export-scan-wait");
+
+	g_hash_table_destroy (seen);
+
+	catalog = g_slice_new0 (ApplauncherCatalog);
+	catalog->ref_count = 1;
+	catalog->n_entries = entries->len;
+	catalog->strings = g_string_chunk_new (64 * 1024);
+	catalog->ids = g_new0 (const gchar *, entries->len);
+	catalog->names = g_new0 (const gchar *, entries->len);
+	catalog->descriptions = g_new0 (const gchar *, entries->len);
+	catalog->icons = g_new0 (GIcon *, entries->len);
+	catalog->keys = g_new0 (const gchar *, entries->len);
+	catalog->plans = g_new0 (ApplauncherLaunchPlan *, entries->len);
+
+	arena = applauncher_arena_new (4096);
+	for (i = 0; i < entries->len; i++)
+		catalog_add_entry (catalog, i, g_ptr_array_index (entries, i), arena);
+	applauncher_arena_free (arena);
+
+	catalog->by_id = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < entries->len; i++) {
+		if (catalog->ids[i])
+			g_hash_table_insert (catalog->by_id, (gpointer) catalog->ids[i], GUINT_TO_POINTER (i + 1));
+	}
+
+	trace = applauncher_trace_begin ();
+	for (i = 0; i < entries->len; i++)
+		catalog->plans[i] = applauncher_launch_plan_new (g_ptr_array_index (entries, i), catalog->ids[i]);
+	catalog_mark_shared_binaries (catalog);
+	applauncher_trace_end (trace, "launch-plans");
+
+	catalog_add_categories (catalog, categories, members);
+	g_free (members);
+
+	/* everything needed has been copied out */
+	g_ptr_array_free (categories, TRUE);
+	g_ptr_array_free (entries, TRUE);
+	g_object_unref (tree);
+
+	return catalog;
+}
+
+static ApplauncherCatalog *
+default_catalog_build (void)
+{
+	gint64 trace;
+	GSList *blacklist;
+	ApplauncherCatalog *catalog;
+
+	trace = applauncher_trace_begin ();
+	blacklist = applauncher_catalog_get_blacklist ();
+	applauncher_trace_end (trace, "blacklist");
+
+	trace = applauncher_trace_begin ();
+	catalog = applauncher_catalog_new (NULL, (const gchar * const *) default_app_dirs, blacklist);
+	g_slist_free_full (blacklist, (GDestroyNotify)g_free);
+	applauncher_trace_end (trace, "catalog-load");
+
+	return catalog;
+}
+
+static void
+default_rebuild_thread (GTask        *task,
+                        gpointer      source_object,
+                        gpointer      task_data,
+                        GCancellable *cancellable)
+{
+	GMainContext *context;
+
+	/* what the menu tree watches is of no use to anyone once it is
+	 * built, so keep it away from the main loop */
+	context = g_main_context_new ();
+	g_main_context_push_thread_default (context);
+
+	g_task_return_pointer (task, default_catalog_build (), (GDestroyNotify) applauncher_catalog_unref);
+
+	g_main_context_pop_thread_default (context);
+	g_main_context_unref (context);
+}
+
+static gboolean default_rebuild_idle (gpointer data);
+
+static void
+default_rebuild_done_cb (GObject      *source_object,
+                         GAsyncResult *result,
+                         gpointer      data)
+{
+	ApplauncherCatalog *catalog;
+
+	default_rebuilding = FALSE;
+
+	catalog = g_task_propagate_pointer (G_TASK (result), NULL);
+
+	/* changed again while it was being built, start over */
+	if (GPOINTER_TO_UINT (data) != default_generation) {
+		applauncher_catalog_unref (catalog);
+		if (default_rebuild_id == 0)
+			default_rebuild_id = g_idle_add_full (G_PRIORITY_LOW, default_rebuild_idle, NULL, NULL);
+		return;
+	}
+
+	if (default_catalog)
+		applauncher_catalog_unref (default_catalog);
+	default_catalog = catalog;
+}
+
+static gboolean
+default_rebuild_idle (gpointer data)
+{
+	GTask *task;
+
+	default_rebuild_id = 0;
+
+	/* one at a time, the one running comes back here when it is done */
+	if (default_rebuilding)
+		return FALSE;
+	default_rebuilding = TRUE;
+
+	task = g_task_new (NULL, NULL, default_rebuild_done_cb, GUINT_TO_POINTER (default_generation));
+	g_task_run_in_thread (task, default_rebuild_thread);
+	g_object_unref (task);
+
+	return FALSE;
+}
+
+/* The catalog in use is kept until its replacement has been built on a
+ * worker, so that the next popup never has to wait for it; bursts of
+ * changes, as a package install makes, cost a single rebuild. */
+static void
+default_catalog_invalidate (void)
+{
+	default_generation++;
+
+	if (default_catalog == NULL || default_rebuild_id != 0)
+		return;
+
+	default_rebuild_id = g_idle_add_full (G_PRIORITY_LOW, default_rebuild_idle, NULL, NULL);
+}
+
+/* Returns a new reference to the catalog of the user's applications menu
+ * and of the exported applications. It is built on first use, and then
+ * rebuilt in the background when the menu files, the exports or the
+ * blacklist change, so that opening the launcher again costs nothing. */
+ApplauncherCatalog *
+applauncher_catalog_get_default (void)
+{
+	guint i;
+
+	if (default_settings == NULL) {
+		default_settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+		g_signal_connect (default_settings, "changed::blacklist",
+		                  G_CALLBACK (default_catalog_invalidate), NULL);
+
+		/* the menu tree is not kept, so watch the installed applications */
+		default_monitor = g_app_info_monitor_get ();
+		g_signal_connect_swapped (default_monitor, "changed",
+		                          G_CALLBACK (default_catalog_invalidate), NULL);
+
+		/* which it does not cover unless they are in XDG_DATA_DIRS */
+		default_app_dirs = get_export_dirs ();
+		default_dir_monitors = g_ptr_array_new_with_free_func (g_object_unref);
+		for (i = 0; default_app_dirs[i] != NULL; i++) {
+			GFile *file = g_file_new_for_path (default_app_dirs[i]);
+			GFileMonitor *monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, NULL);
+
+			if (monitor) {
+				g_signal_connect_swapped (monitor, "changed",
+				                          G_CALLBACK (default_catalog_invalidate), NULL);
+				g_ptr_array_add (default_dir_monitors, monitor);
+			}
+			g_object_unref (file);
+		}
+	}
+
+	if (default_catalog == NULL)
+		default_catalog = default_catalog_build ();
+
+	return applauncher_catalog_ref (default_catalog);
+}
+
+ApplauncherCatalog *
+applauncher_catalog_ref (ApplauncherCatalog *catalog)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+
+	g_atomic_int_inc (&catalog->ref_count);
+
+	return catalog;
+}
+
+void
+applauncher_catalog_unref (ApplauncherCatalog *catalog)
+{
+	guint i;
+
+	g_return_if_fail (catalog != NULL);
+
+	if (!g_atomic_int_dec_and_test (&catalog->ref_count))
+		return;
+
+	for (i = 0; i < catalog->n_entries; i++) {
+		if (catalog->icons[i])
+			g_object_unref (catalog->icons[i]);
+		applauncher_launch_plan_free (catalog->plans[i]);
+	}
+
+	g_free (catalog->ids);
+	g_free (catalog->names);
+	g_free (catalog->descriptions);
+	g_free (catalog->icons);
+	g_free (catalog->keys);
+	g_free (catalog->plans);
+
+	for (i = 0; i < catalog->n_categories; i++) {
+		if (catalog->category_icons[i])
+			g_object_unref (catalog->category_icons[i]);
+	}
+	g_free (catalog->category_names);
+	g_free (catalog->category_icons);
+	g_free (catalog->category_offsets);
+	g_free (catalog->category_members);
+
+	g_hash_table_destroy (catalog->by_id);
+
+	g_string_chunk_free (catalog->strings);
+
+	g_slice_free (ApplauncherCatalog, catalog);
+}
+
+guint
+applauncher_catalog_get_n_entries (ApplauncherCatalog *catalog)
+{
+	g_return_val_if_fail (catalog != NULL, 0);
+
+	return catalog->n_entries;
+}
+
+const gchar *
+applauncher_catalog_get_id (ApplauncherCatalog *catalog,
+                            guint               index)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (index < catalog->n_entries, NULL);
+
+	return catalog->ids[index];
+}
+
+/* The name in the current locale. */
+const gchar *
+applauncher_catalog_get_name (ApplauncherCatalog *catalog,
+                              guint               index)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (index < catalog->n_entries, NULL);
+
+	return catalog->names[index];
+}
+
+const gchar *
+applauncher_catalog_get_description (ApplauncherCatalog *catalog,
+                                     guint               index)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (index < catalog->n_entries, NULL);
+
+	return catalog->descriptions[index];
+}
+
+GIcon *
+applauncher_catalog_get_icon (ApplauncherCatalog *catalog,
+                              guint               index)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (index < catalog->n_entries, NULL);
+
+	return catalog->icons[index];
+}
+
+guint
+applauncher_catalog_get_n_categories (ApplauncherCatalog *catalog)
+{
+	g_return_val_if_fail (catalog != NULL, 0);
+
+	return catalog->n_categories;
+}
+
+/* The name of the menu directory, in the current locale. */
+const gchar *
+applauncher_catalog_get_category_name (ApplauncherCatalog *catalog,
+                                       guint               category)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (category < catalog->n_categories, NULL);
+
+	return catalog->category_names[category];
+}
+
+GIcon *
+applauncher_catalog_get_category_icon (ApplauncherCatalog *catalog,
+                                       guint               category)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (category < catalog->n_categories, NULL);
+
+	return catalog->category_icons[category];
+}
+
+/* Returns the indexes of the entries in @category, sorted. */
+const guint *
+applauncher_catalog_get_category_members (ApplauncherCatalog *catalog,
+                                          guint               category,
+                                          guint              *n_members)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (category < catalog->n_categories, NULL);
+	g_return_val_if_fail (n_members != NULL, NULL);
+
+	*n_members = catalog->category_offsets[category + 1] - catalog->category_offsets[category];
+
+	return catalog->category_members + catalog->category_offsets[category];
+}
+
+/* Replaces the contents of @out with the indexes found in both @a and
+ * @b, which must be sorted, as applauncher_catalog_search_into() and
+ * applauncher_catalog_get_category_members() return them. */
+void
+applauncher_catalog_intersect (const guint *a,
+                               guint        n_a,
+                               const guint *b,
+                               guint        n_b,
+                               GArray      *out)
+{
+	guint i = 0, j = 0;
+
+	g_return_if_fail (out != NULL);
+
+	g_array_set_size (out, 0);
+
+	while (i < n_a && j < n_b) {
+		if (a[i] < b[j]) {
+			i++;
+		} else if (a[i] > b[j]) {
+			j++;
+		} else {
+			g_array_append_val (out, a[i]);
+			i++;
+			j++;
+		}
+	}
+}
+
+guint
+applauncher_catalog_count_pages (guint n_entries,
+                                 guint page_size)
+{
+	g_return_val_if_fail (page_size > 0, 0);
+
+	return (n_entries + page_size - 1) / page_size;
+}
+
+const ApplauncherLaunchPlan *
+applauncher_catalog_get_launch_plan (ApplauncherCatalog *catalog,
+                                     guint               index)
+{
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (index < catalog->n_entries, NULL);
+
+	return catalog->plans[index];
+}
+
+/* Returns the index of the entry with @desktop_id, or -1. */
+gint
+applauncher_catalog_find (ApplauncherCatalog *catalog,
+                          const gchar        *desktop_id)
+{
+	g_return_val_if_fail (catalog != NULL, -1);
+	g_return_val_if_fail (desktop_id != NULL, -1);
+
+	return (gint) GPOINTER_TO_UINT (g_hash_table_lookup (catalog->by_id, desktop_id)) - 1;
+}
+
+/* Same folding as fold_append(), for a query, into @arena. */
+static const gchar *
+fold_query (ApplauncherArena *arena, const gchar *text)
+{
+	const gchar *p;
+	gchar *folded, *q;
+
+	if (!text || !g_utf8_validate (text, -1, NULL))
+		return "";
+
+	q = folded = applauncher_arena_alloc (arena, g_utf8_strlen (text, -1) * 6 + 1);
+	for (p = text; *p != '\0'; p = g_utf8_next_char (p))
+		q += g_unichar_to_utf8 (g_unichar_tolower (g_utf8_get_char (p)), q);
+	*q = '\0';
+
+	return folded;
+}
+
+/* Replaces the contents of @matches with the indexes of the entries
+ * matching @text, taking any temporary memory from @arena. Once both
+ * have grown to fit, a search allocates nothing. Returns %FALSE if
+ * @cancellable was cancelled meanwhile. Safe to call from any thread. */
+gboolean
+applauncher_catalog_search_into (ApplauncherCatalog *catalog,
+                                 const gchar        *text,
+                                 ApplauncherArena   *arena,
+                                 GArray             *matches,
+                                 GCancellable       *cancellable)
+{
+	guint i;
+	const gchar *folded;
+
+	g_return_val_if_fail (catalog != NULL, FALSE);
+	g_return_val_if_fail (arena != NULL, FALSE);
+	g_return_val_if_fail (matches != NULL, FALSE);
+
+	folded = fold_query (arena, text);
+
+	g_array_set_size (matches, 0);
+
+	for (i = 0; i < catalog->n_entries; i++) {
+		if ((i % 64) == 0 && g_cancellable_is_cancelled (cancellable))
+			return FALSE;
+
+		if (strstr (catalog->keys[i], folded) != NULL)
+			g_array_append_val (matches, i);
+	}
+
+	return TRUE;
+}
+
+/* Returns the indexes of the entries matching @text, or %NULL if
+ * @cancellable was cancelled meanwhile. Safe to call from any thread. */
+GArray *
+applauncher_catalog_search (ApplauncherCatalog *catalog,
+                            const gchar        *text,
+                            GCancellable       *cancellable)
+{
+	GArray *matches;
+	ApplauncherArena *arena;
+
+	g_return_val_if_fail (catalog != NULL, NULL);
+
+	arena = applauncher_arena_new (256);
+	matches = g_array_sized_new (FALSE, FALSE, sizeof (guint), catalog->n_entries);
+
+	if (!applauncher_catalog_search_into (catalog, text, arena, matches, cancellable)) {
+		g_array_unref (matches);
+		matches = NULL;
+	}
+
+	applauncher_arena_free (arena);
+
+	return matches;
+}
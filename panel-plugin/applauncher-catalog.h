@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __APPLAUNCHER_CATALOG_H__
+#define __APPLAUNCHER_CATALOG_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "applauncher-arena.h"
+#include "applauncher-launch.h"
+
+G_BEGIN_DECLS
+
+typedef struct _ApplauncherCatalog ApplauncherCatalog;
+
+ApplauncherCatalog *applauncher_catalog_new             (const gchar        *menu_file,
+                                                         const gchar * const *app_dirs,
+                                                         GSList             *blacklist);
+
+ApplauncherCatalog *applauncher_catalog_get_default     (void);
+
+ApplauncherCatalog *applauncher_catalog_ref             (ApplauncherCatalog *catalog);
+
+void                applauncher_catalog_unref           (ApplauncherCatalog *catalog);
+
+guint               applauncher_catalog_get_n_entries   (ApplauncherCatalog *catalog);
+
+const gchar        *applauncher_catalog_get_id          (ApplauncherCatalog *catalog,
+                                                         guint               index);
+
+const gchar        *applauncher_catalog_get_name        (ApplauncherCatalog *catalog,
+                                                         guint               index);
+
+const gchar        *applauncher_catalog_get_description (ApplauncherCatalog *catalog,
+                                                         guint               index);
+
+GIcon              *applauncher_catalog_get_icon        (ApplauncherCatalog *catalog,
+                                                         guint               index);
+
+const ApplauncherLaunchPlan *
+                    applauncher_catalog_get_launch_plan (ApplauncherCatalog *catalog,
+                                                         guint               index);
+
+gint                applauncher_catalog_find            (ApplauncherCatalog *catalog,
+                                                         const gchar        *desktop_id);
+
+GArray             *applauncher_catalog_search          (ApplauncherCatalog *catalog,
+                                                         const gchar        *text,
+                                                         GCancellable       *cancellable);
+
+gboolean            applauncher_catalog_search_into     (ApplauncherCatalog *catalog,
+                                                         const gchar        *text,
+                                                         ApplauncherArena   *arena,
+                                                         GArray             *matches,
+                                                         GCancellable       *cancellable);
+
+GSList             *applauncher_catalog_resolve_blacklist (gchar           **blacklist,
+                                                           GList            *app_infos);
+
+GSList             *applauncher_catalog_get_blacklist   (void);
+
+guint               applauncher_catalog_get_n_categories (ApplauncherCatalog *catalog);
+
+const gchar        *applauncher_catalog_get_category_name (ApplauncherCatalog *catalog,
+                                                           guint               category);
+
+GIcon              *applauncher_catalog_get_category_icon (ApplauncherCatalog *catalog,
+                                                           guint               category);
+
+const guint        *applauncher_catalog_get_category_members (ApplauncherCatalog *catalog,
+                                                              guint               category,
+                                                              guint              *n_members);
+
+void                applauncher_catalog_intersect       (const guint        *a,
+                                                         guint               n_a,
+                                                         const guint        *b,
+                                                         guint               n_b,
+                                                         GArray             *out);
+
+guint               applauncher_catalog_count_pages     (guint               n_entries,
+                                                         guint               page_size);
+
+G_END_DECLS
+
+#endif /* !__APPLAUNCHER_CATALOG_H__ */
@@ -0,0 +1,258 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* The applications pinned to the first page of the launcher, kept in
+ * the "favorites" key. Their icons are rendered ahead of time, while
+ * the panel is idle, so that opening the launcher on them loads no
+ * icon at all: a GdkPixbuf is a GIcon, which GtkImage shows as is. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gtk/gtk.h>
+
+#include "applauncher-trace.h"
+#include "applauncher-favorites.h"
+
+
+static GSettings    *settings = NULL;
+static gchar       **favorites = NULL;
+
+/* desktop id to GdkPixbuf, all rendered at icon_size and icon_scale */
+static GHashTable   *icons = NULL;
+static gint          icon_size = 0;
+static gint          icon_scale = 0;
+static GtkIconTheme *icon_theme = NULL;
+
+
+
+static void
+on_favorites_changed (GSettings *gsettings, const gchar *key, gpointer data)
+{
+	g_strfreev (favorites);
+	favorites = g_settings_get_strv (settings, "favorites");
+}
+
+static void
+on_icon_theme_changed (GtkIconTheme *theme, gpointer data)
+{
+	g_hash_table_remove_all (icons);
+}
+
+void
+applauncher_favorites_init (void)
+{
+	if (settings != NULL)
+		return;
+
+	settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	g_signal_connect (settings, "changed::favorites", G_CALLBACK (on_favorites_changed), NULL);
+	favorites = g_settings_get_strv (settings, "favorites");
+
+	icons = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+}
+
+void
+applauncher_favorites_shutdown (void)
+{
+	if (settings == NULL)
+		return;
+
+	if (icon_theme) {
+		g_signal_handlers_disconnect_by_func (icon_theme, on_icon_theme_changed, NULL);
+		g_clear_object (&icon_theme);
+	}
+
+	g_clear_pointer (&icons, g_hash_table_destroy);
+	g_clear_pointer (&favorites, g_strfreev);
+	g_clear_object (&settings);
+}
+
+/* Returns the desktop ids, in order; owned by this module. */
+const gchar * const *
+applauncher_favorites_get (void)
+{
+	static const gchar *none[] = { NULL };
+
+	return favorites ? (const gchar * const *) favorites : none;
+}
+
+gboolean
+applauncher_favorites_contains (const gchar *desktop_id)
+{
+	const gchar * const *ids = applauncher_favorites_get ();
+	guint i;
+
+	if (desktop_id == NULL)
+		return FALSE;
+
+	for (i = 0; ids[i] != NULL; i++) {
+		if (g_str_equal (ids[i], desktop_id))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void
+favorites_store (GPtrArray *ids)
+{
+	g_ptr_array_add (ids, NULL);
+	g_settings_set_strv (settings, "favorites", (const gchar * const *) ids->pdata);
+	g_ptr_array_free (ids, TRUE);
+}
+
+/* The favorites other than @desktop_id, in order, in a new array of
+ * borrowed strings. */
+static GPtrArray *
+favorites_without (const gchar *desktop_id)
+{
+	const gchar * const *ids = applauncher_favorites_get ();
+	GPtrArray *copy = g_ptr_array_new ();
+	guint i;
+
+	for (i = 0; ids[i] != NULL; i++) {
+		if (g_strcmp0 (ids[i], desktop_id) != 0)
+			g_ptr_array_add (copy, (gpointer) ids[i]);
+	}
+
+	return copy;
+}
+
+void
+applauncher_favorites_add (const gchar *desktop_id)
+{
+	GPtrArray *ids;
+
+	g_return_if_fail (settings != NULL);
+	g_return_if_fail (desktop_id != NULL);
+
+	if (applauncher_favorites_contains (desktop_id))
+		return;
+
+	ids = favorites_without (NULL);
+	g_ptr_array_add (ids, (gpointer) desktop_id);
+	favorites_store (ids);
+}
+
+void
+applauncher_favorites_remove (const gchar *desktop_id)
+{
+	g_return_if_fail (settings != NULL);
+	g_return_if_fail (desktop_id != NULL);
+
+	if (!applauncher_favorites_contains (desktop_id))
+		return;
+
+	favorites_store (favorites_without (desktop_id));
+	g_hash_table_remove (icons, desktop_id);
+}
+
+void
+applauncher_favorites_move (const gchar *desktop_id, guint position)
+{
+	GPtrArray *ids;
+
+	g_return_if_fail (settings != NULL);
+	g_return_if_fail (desktop_id != NULL);
+
+	if (!applauncher_favorites_contains (desktop_id))
+		return;
+
+	ids = favorites_without (desktop_id);
+	g_ptr_array_insert (ids, MIN (position, ids->len), (gpointer) desktop_id);
+	favorites_store (ids);
+}
+
+/* Renders the icons of the favorites that are not already, at @size
+ * pixels and @scale. Any favorite added later is rendered on the next
+ * call. */
+void
+applauncher_favorites_prerender (ApplauncherCatalog *catalog,
+                                 GdkScreen          *screen,
+                                 gint                size,
+                                 gint                scale)
+{
+	const gchar * const *ids = applauncher_favorites_get ();
+	GtkIconTheme *theme;
+	gint64 trace;
+	guint i;
+
+	g_return_if_fail (settings != NULL);
+
+	theme = gtk_icon_theme_get_for_screen (screen);
+	if (theme != icon_theme) {
+		if (icon_theme) {
+			g_signal_handlers_disconnect_by_func (icon_theme, on_icon_theme_changed, NULL);
+			g_object_unref (icon_theme);
+		}
+		icon_theme = g_object_ref (theme);
+		g_signal_connect (icon_theme, "changed", G_CALLBACK (on_icon_theme_changed), NULL);
+		g_hash_table_remove_all (icons);
+	}
+
+	if (size != icon_size || scale != icon_scale) {
+		g_hash_table_remove_all (icons);
+		icon_size = size;
+		icon_scale = scale;
+	}
+
+	trace = applauncher_trace_begin ();
+	for (i = 0; ids[i] != NULL; i++) {
+		GtkIconInfo *info;
+		GdkPixbuf *pixbuf;
+		GIcon *gicon;
+		gint index;
+
+		if (g_hash_table_contains (icons, ids[i]))
+			continue;
+
+		index = applauncher_catalog_find (catalog, ids[i]);
+		if (index < 0)
+			continue;
+
+		gicon = applauncher_catalog_get_icon (catalog, index);
+		if (!gicon)
+			continue;
+
+		info = gtk_icon_theme_lookup_by_gicon_for_scale (theme, gicon, size, scale,
+		                                                 GTK_ICON_LOOKUP_FORCE_SIZE);
+		if (!info)
+			continue;
+
+		pixbuf = gtk_icon_info_load_icon (info, NULL);
+		if (pixbuf)
+			g_hash_table_insert (icons, g_strdup (ids[i]), pixbuf);
+		g_object_unref (info);
+	}
+	applauncher_trace_end (trace, "favorites-prerender");
+}
+
+/* Returns the pre-rendered icon of @desktop_id, or NULL if there is
+ * none at @size. */
+GIcon *
+applauncher_favorites_get_icon (const gchar *desktop_id, gint size)
+{
+	if (icons == NULL || size != icon_size || desktop_id == NULL)
+		return NULL;
+
+	return g_hash_table_lookup (icons, desktop_id);
+}
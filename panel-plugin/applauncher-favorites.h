@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __APPLAUNCHER_FAVORITES_H__
+#define __APPLAUNCHER_FAVORITES_H__
+
+#include <gtk/gtk.h>
+
+#include "applauncher-catalog.h"
+
+G_BEGIN_DECLS
+
+void                 applauncher_favorites_init      (void);
+
+void                 applauncher_favorites_shutdown  (void);
+
+const gchar * const *applauncher_favorites_get       (void);
+
+gboolean             applauncher_favorites_contains  (const gchar        *desktop_id);
+
+void                 applauncher_favorites_add       (const gchar        *desktop_id);
+
+void                 applauncher_favorites_remove    (const gchar        *desktop_id);
+
+void                 applauncher_favorites_move      (const gchar        *desktop_id,
+                                                      guint               position);
+
+void                 applauncher_favorites_prerender (ApplauncherCatalog *catalog,
+                                                      GdkScreen          *screen,
+                                                      gint                size,
+                                                      gint                scale);
+
+GIcon               *applauncher_favorites_get_icon  (const gchar        *desktop_id,
+                                                      gint                size);
+
+G_END_DECLS
+
+#endif /* !__APPLAUNCHER_FAVORITES_H__ */
@@ -0,0 +1,209 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "applauncher-latency.h"
+
+
+/* number of most recent samples kept per histogram */
+#define HISTOGRAM_SIZE        (1024)
+
+/* dump the percentiles every this many keystrokes */
+#define REPORT_INTERVAL       (50)
+
+
+struct _ApplauncherHistogram
+{
+	gint64 samples[HISTOGRAM_SIZE];
+	guint  n_samples;
+	guint  next;
+};
+
+
+static const gchar *stage_names[APPLAUNCHER_LATENCY_N_STAGES] = {
+	"search",
+	"grid",
+	"present"
+};
+
+static ApplauncherHistogram *stages[APPLAUNCHER_LATENCY_N_STAGES];
+
+
+
+static int
+compare_int64 (gconstpointer a, gconstpointer b)
+{
+	gint64 va = *(const gint64 *)a;
+	gint64 vb = *(const gint64 *)b;
+
+	return (va > vb) - (va < vb);
+}
+
+ApplauncherHistogram *
+applauncher_histogram_new (void)
+{
+	return g_new0 (ApplauncherHistogram, 1);
+}
+
+void
+applauncher_histogram_free (ApplauncherHistogram *histogram)
+{
+	g_free (histogram);
+}
+
+void
+applauncher_histogram_add (ApplauncherHistogram *histogram,
+                           gint64                value)
+{
+	g_return_if_fail (histogram != NULL);
+
+	histogram->samples[histogram->next] = value;
+	histogram->next = (histogram->next + 1) % HISTOGRAM_SIZE;
+
+	if (histogram->n_samples < HISTOGRAM_SIZE)
+		histogram->n_samples++;
+}
+
+guint
+applauncher_histogram_get_count (ApplauncherHistogram *histogram)
+{
+	g_return_val_if_fail (histogram != NULL, 0);
+
+	return histogram->n_samples;
+}
+
+gint64
+applauncher_histogram_percentile (ApplauncherHistogram *histogram,
+                                  gdouble               percent)
+{
+	gint64 sorted[HISTOGRAM_SIZE];
+	guint rank;
+
+	g_return_val_if_fail (histogram != NULL, 0);
+
+	if (histogram->n_samples == 0)
+		return 0;
+
+	memcpy (sorted, histogram->samples, histogram->n_samples * sizeof (gint64));
+	qsort (sorted, histogram->n_samples, sizeof (gint64), compare_int64);
+
+	/* nearest-rank method */
+	rank = (guint)((percent / 100.0) * histogram->n_samples + 0.5);
+	rank = CLAMP (rank, 1, histogram->n_samples);
+
+	return sorted[rank - 1];
+}
+
+/* Enabled by setting APPLAUNCHER_DEBUG_LATENCY in the panel's environment.
+ * An absolute path makes the report go to that file, anything else to
+ * the panel's standard error. */
+gboolean
+applauncher_latency_enabled (void)
+{
+	static gint enabled = -1;
+
+	if (G_UNLIKELY (enabled == -1))
+		enabled = (g_getenv ("APPLAUNCHER_DEBUG_LATENCY") != NULL);
+
+	return enabled;
+}
+
+void
+applauncher_latency_log (const gchar *format, ...)
+{
+	va_list args;
+	gchar *message;
+	const gchar *path;
+
+	va_start (args, format);
+	message = g_strdup_vprintf (format, args);
+	va_end (args);
+
+	path = g_getenv ("APPLAUNCHER_DEBUG_LATENCY");
+
+	if (path && g_path_is_absolute (path)) {
+		FILE *fp = fopen (path, "a");
+		if (fp) {
+			fprintf (fp, "%" G_GINT64_FORMAT " %s\n", g_get_real_time () / G_USEC_PER_SEC, message);
+			fclose (fp);
+		}
+	} else {
+		g_printerr ("applauncher: %s\n", message);
+	}
+
+	g_free (message);
+}
+
+void
+applauncher_latency_record (ApplauncherLatencyStage stage,
+                            gint64                  usec)
+{
+	g_return_if_fail (stage < APPLAUNCHER_LATENCY_N_STAGES);
+
+	if (!applauncher_latency_enabled ())
+		return;
+
+	if (G_UNLIKELY (stages[stage] == NULL))
+		stages[stage] = applauncher_histogram_new ();
+
+	applauncher_histogram_add (stages[stage], usec);
+
+	/* the last stage closes a keystroke */
+	if (stage == APPLAUNCHER_LATENCY_PRESENT
+	    && (applauncher_histogram_get_count (stages[stage]) % REPORT_INTERVAL) == 0)
+		applauncher_latency_report ();
+}
+
+void
+applauncher_latency_report (void)
+{
+	guint i;
+	GString *string;
+
+	if (!applauncher_latency_enabled ())
+		return;
+
+	string = g_string_new ("keystroke latency (ms, p50/p95/p99):");
+
+	for (i = 0; i < APPLAUNCHER_LATENCY_N_STAGES; i++) {
+		ApplauncherHistogram *histogram = stages[i];
+
+		if (histogram == NULL)
+			continue;
+
+		g_string_append_printf (string, " %s=%.1f/%.1f/%.1f (n=%u)",
+		                        stage_names[i],
+		                        applauncher_histogram_percentile (histogram, 50) / 1000.0,
+		                        applauncher_histogram_percentile (histogram, 95) / 1000.0,
+		                        applauncher_histogram_percentile (histogram, 99) / 1000.0,
+		                        applauncher_histogram_get_count (histogram));
+	}
+
+	applauncher_latency_log ("%s", string->str);
+
+	g_string_free (string, TRUE);
+}
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __APPLAUNCHER_LATENCY_H__
+#define __APPLAUNCHER_LATENCY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ApplauncherHistogram ApplauncherHistogram;
+
+/* stages of search-as-you-type, all measured from the keystroke */
+typedef enum
+{
+	APPLAUNCHER_LATENCY_SEARCH,
+	APPLAUNCHER_LATENCY_GRID,
+	APPLAUNCHER_LATENCY_PRESENT,
+	APPLAUNCHER_LATENCY_N_STAGES
+} ApplauncherLatencyStage;
+
+ApplauncherHistogram *applauncher_histogram_new        (void);
+
+void                  applauncher_histogram_free       (ApplauncherHistogram *histogram);
+
+void                  applauncher_histogram_add        (ApplauncherHistogram *histogram,
+                                                        gint64                value);
+
+guint                 applauncher_histogram_get_count  (ApplauncherHistogram *histogram);
+
+gint64                applauncher_histogram_percentile (ApplauncherHistogram *histogram,
+                                                        gdouble               percent);
+
+gboolean              applauncher_latency_enabled      (void);
+
+void                  applauncher_latency_record       (ApplauncherLatencyStage stage,
+                                                        gint64                  usec);
+
+void                  applauncher_latency_report       (void);
+
+void                  applauncher_latency_log          (const gchar *format,
+                                                        ...) G_GNUC_PRINTF (1, 2);
+
+G_END_DECLS
+
+#endif /* !__APPLAUNCHER_LATENCY_H__ */
@@ -0,0 +1,281 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Checks D-Bus activation of DBusActivatable applications on a bus of
+ * its own, under dbus-run-session: a stub org.freedesktop.Application
+ * must get Activate on the path the desktop id gives, with the startup
+ * id in its platform data, and an application that is not on the bus
+ * must fail to activate and still have an Exec line to run instead.
+ * Built and run by "make check". */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gdesktopappinfo.h>
+
+#include "applauncher-launch.h"
+#include "applauncher-spawn.h"
+#include "applauncher-test-menu.h"
+
+
+#define TEST_SKIP       (77)    /* what automake takes for a skipped test */
+#define TEST_BUS_ENV    "APPLAUNCHER_TEST_BUS"
+#define TEST_NAME       "org.gooroom.ApplauncherTest"
+#define TEST_PATH       "/org/gooroom/ApplauncherTest"
+#define TEST_MISSING    "org.gooroom.ApplauncherTestMissing"
+#define TEST_STARTUP_ID "applauncher-test_TIME1234"
+
+static const gchar introspection[] =
+	"<node>"
+	"  <interface name='org.freedesktop.Application'>"
+	"    <method name='Activate'>"
+	"      <arg type='a{sv}' name='platform_data' direction='in'/>"
+	"    </method>"
+	"  </interface>"
+	"</node>";
+
+static GVariant *activated = NULL;
+static int       n_failures = 0;
+
+
+
+static void
+test_method_call (GDBusConnection       *connection,
+                  const gchar           *sender,
+                  const gchar           *object_path,
+                  const gchar           *interface_name,
+                  const gchar           *method_name,
+                  GVariant              *parameters,
+                  GDBusMethodInvocation *invocation,
+                  gpointer               data)
+{
+	if (g_strcmp0 (method_name, "Activate") == 0 && activated == NULL)
+		activated = g_variant_ref (parameters);
+
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static const GDBusInterfaceVTable test_vtable = { test_method_call, NULL, NULL };
+
+static void
+test_fail (const gchar *what)
+{
+	g_printerr ("applauncher-launch-test: %s\n", what);
+	n_failures++;
+}
+
+static ApplauncherLaunchPlan *
+test_plan_new (const gchar *dir, const gchar *name, const gchar *exec)
+{
+	ApplauncherLaunchPlan *plan = NULL;
+	GDesktopAppInfo *app_info;
+	gchar *id, *path, *contents;
+
+	id = g_strconcat (name, ".desktop", NULL);
+	path = g_build_filename (dir, id, NULL);
+	contents = g_strdup_printf ("[Desktop Entry]\n"
+	                            "Type=Application\n"
+	                            "Name=%s\n"
+	                            "Exec=%s\n"
+	                            "DBusActivatable=true\n",
+	                            name, exec);
+
+	if (g_file_set_contents (path, contents, -1, NULL)) {
+		app_info = g_desktop_app_info_new_from_filename (path);
+		if (app_info) {
+			plan = applauncher_launch_plan_new (app_info, id);
+			g_object_unref (app_info);
+		}
+	}
+
+	g_free (contents);
+	g_free (path);
+	g_free (id);
+
+	return plan;
+}
+
+typedef struct
+{
+	gboolean  done;
+	GError   *error;
+} TestActivation;
+
+static void
+test_activate_done_cb (GObject *source, GAsyncResult *result, gpointer data)
+{
+	TestActivation *activation = data;
+
+	applauncher_launch_plan_activate_finish (result, &activation->error);
+	activation->done = TRUE;
+}
+
+/* Returns the error of the activation, or %NULL if it went through. */
+static GError *
+test_activate (const ApplauncherLaunchPlan *plan, const gchar *startup_id)
+{
+	TestActivation activation = { FALSE, NULL };
+
+	applauncher_launch_plan_activate (plan, startup_id, NULL, test_activate_done_cb, &activation);
+	while (!activation.done)
+		g_main_context_iteration (NULL, TRUE);
+
+	return activation.error;
+}
+
+static void
+test_activate_running (GDBusConnection *connection, const ApplauncherLaunchPlan *plan)
+{
+	GDBusNodeInfo *node;
+	GVariant *platform_data;
+	GError *error = NULL;
+	const gchar *id = NULL, *token = NULL;
+
+	if (!plan || g_strcmp0 (plan->dbus_name, TEST_NAME) != 0 || g_strcmp0 (plan->dbus_path, TEST_PATH) != 0) {
+		test_fail ("no bus name and path from the desktop id");
+		return;
+	}
+
+	node = g_dbus_node_info_new_for_xml (introspection, NULL);
+	g_dbus_connection_register_object (connection, TEST_PATH, node->interfaces[0],
+	                                   &test_vtable, NULL, NULL, NULL);
+	g_dbus_node_info_unref (node);
+
+	if (!g_dbus_connection_call_sync (connection, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+	                                  "org.freedesktop.DBus", "RequestName",
+	                                  g_variant_new ("(su)", TEST_NAME, 0), G_VARIANT_TYPE ("(u)"),
+	                                  G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL)) {
+		test_fail ("cannot own " TEST_NAME);
+		return;
+	}
+
+	error = test_activate (plan, TEST_STARTUP_ID);
+	if (error) {
+		test_fail (error->message);
+		g_error_free (error);
+		return;
+	}
+
+	if (!activated) {
+		test_fail ("Activate never reached the application");
+		return;
+	}
+
+	platform_data = g_variant_get_child_value (activated, 0);
+	g_variant_lookup (platform_data, "desktop-startup-id", "&s", &id);
+	g_variant_lookup (platform_data, "activation-token", "&s", &token);
+	if (g_strcmp0 (id, TEST_STARTUP_ID) != 0 || g_strcmp0 (token, TEST_STARTUP_ID) != 0)
+		test_fail ("no startup id in the platform data");
+	g_variant_unref (platform_data);
+}
+
+/* What the launcher does when activation fails: run the Exec line. */
+static void
+test_activate_missing (const ApplauncherLaunchPlan *plan, const gchar *marker)
+{
+	GError *error;
+	GPid pid;
+	gint status = -1;
+
+	if (!plan || !plan->dbus_name || !plan->argv) {
+		test_fail ("no bus name or no Exec line for " TEST_MISSING);
+		return;
+	}
+
+	error = test_activate (plan, NULL);
+	if (!error) {
+		test_fail ("activated an application that is not on the bus");
+		return;
+	}
+	g_error_free (error);
+
+	if (!applauncher_spawn_async (plan->working_directory, plan->argv, NULL,
+	                              G_SPAWN_DO_NOT_REAP_CHILD, &pid, &error)) {
+		test_fail (error->message);
+		g_error_free (error);
+		return;
+	}
+	waitpid (pid, &status, 0);
+	g_spawn_close_pid (pid);
+
+	if (!g_file_test (marker, G_FILE_TEST_EXISTS))
+		test_fail ("the Exec line did not run");
+}
+
+int
+main (int argc, char **argv)
+{
+	GDBusConnection *connection;
+	ApplauncherLaunchPlan *running, *missing;
+	gchar *dir, *marker, *exec;
+
+	/* never on the session bus of whoever runs the tests */
+	if (!g_getenv (TEST_BUS_ENV)) {
+		gchar *run_session = g_find_program_in_path ("dbus-run-session");
+		gchar *daemon = g_find_program_in_path ("dbus-daemon");
+
+		if (!run_session || !daemon) {
+			g_printerr ("applauncher-launch-test: dbus-run-session or dbus-daemon not found\n");
+			return TEST_SKIP;
+		}
+
+		g_free (daemon);
+		g_setenv (TEST_BUS_ENV, "1", TRUE);
+		execl (run_session, run_session, "--", argv[0], (char *) NULL);
+
+		g_printerr ("applauncher-launch-test: cannot run dbus-run-session\n");
+		return TEST_SKIP;
+	}
+
+	connection = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+	if (!connection) {
+		g_printerr ("applauncher-launch-test: no session bus\n");
+		return TEST_SKIP;
+	}
+
+	dir = g_dir_make_tmp ("applauncher-test-XXXXXX", NULL);
+	if (!dir)
+		return TEST_SKIP;
+
+	marker = g_build_filename (dir, "exec-ran", NULL);
+	exec = g_strdup_printf ("touch %s", marker);
+
+	running = test_plan_new (dir, TEST_NAME, "true");
+	missing = test_plan_new (dir, TEST_MISSING, exec);
+
+	test_activate_running (connection, running);
+	test_activate_missing (missing, marker);
+
+	applauncher_launch_plan_free (running);
+	applauncher_launch_plan_free (missing);
+	g_object_unref (connection);
+
+	applauncher_test_remove_tree (dir);
+	g_free (exec);
+	g_free (marker);
+	g_free (dir);
+
+	return n_failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,339 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Turns the Exec line of an application into an argument vector that
+ * can be spawned, and activates DBusActivatable applications through
+ * org.freedesktop.Application. Nothing in here needs a display. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gdesktopappinfo.h>
+
+#include "applauncher-launch.h"
+
+
+#define DBUS_ACTIVATABLE_KEY "DBusActivatable"
+
+typedef struct
+{
+	gchar *name;
+	gchar *path;
+	gchar *startup_id;
+} ActivateData;
+
+
+static gboolean
+command_is_executable (const char   *command,
+                       char        **pathp,
+                       char       ***argvp)
+{
+	gboolean   result;
+	char     **argv;
+	char      *path;
+
+	result = g_shell_parse_argv (command, NULL, &argv, NULL);
+
+	if (!result)
+		return FALSE;
+
+	path = g_find_program_in_path (argv[0]);
+
+	if (!path) {
+		g_strfreev (argv);
+		return FALSE;
+	}
+
+	/* If we pass an absolute path to g_find_program it just returns
+	 * that absolute path without checking if it is executable. Also
+	 * make sure its a regular file so we don't try to launch
+	 * directories or device nodes.
+	 */
+	if (!g_file_test (path, G_FILE_TEST_IS_EXECUTABLE) ||
+        !g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+		g_free (path);
+		g_strfreev (argv);
+		return FALSE;
+	}
+
+	if (pathp)
+		*pathp = path;
+	else
+		g_free (path);
+
+	if (argvp)
+		*argvp = argv;
+	else
+		g_strfreev (argv);
+
+	return TRUE;
+}
+
+/* Bus name and object path from the desktop id, as the Desktop Entry
+ * specification lays out: org.example.App-Name.desktop is activated as
+ * org.example.App-Name on /org/example/App_Name. */
+static gboolean
+dbus_name_from_app_info (GDesktopAppInfo *app_info, const gchar *id, gchar **namep, gchar **pathp)
+{
+	gchar *name, *p;
+	GString *path;
+
+	if (!g_desktop_app_info_get_boolean (app_info, DBUS_ACTIVATABLE_KEY))
+		return FALSE;
+
+	if (!id || !g_str_has_suffix (id, ".desktop"))
+		return FALSE;
+
+	name = g_strndup (id, strlen (id) - strlen (".desktop"));
+	if (!g_dbus_is_name (name) || g_dbus_is_unique_name (name)) {
+		g_free (name);
+		return FALSE;
+	}
+
+	path = g_string_new ("/");
+	for (p = name; *p != '\0'; p++) {
+		if (*p == '.')
+			g_string_append_c (path, '/');
+		else if (*p == '-')
+			g_string_append_c (path, '_');
+		else
+			g_string_append_c (path, *p);
+	}
+
+	*namep = name;
+	*pathp = g_string_free (path, FALSE);
+
+	return TRUE;
+}
+
+static void
+activate_data_free (gpointer data)
+{
+	ActivateData *activate = data;
+
+	g_free (activate->name);
+	g_free (activate->path);
+	g_free (activate->startup_id);
+	g_slice_free (ActivateData, activate);
+}
+
+static void
+activate_call_done_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GError *error = NULL;
+	GVariant *ret;
+
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (ret) {
+		g_variant_unref (ret);
+		g_task_return_boolean (task, TRUE);
+	} else {
+		g_task_return_error (task, error);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+activate_bus_ready_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ActivateData *activate = g_task_get_task_data (task);
+	GDBusConnection *connection;
+	GVariantBuilder platform_data;
+	GError *error = NULL;
+
+	connection = g_bus_get_finish (result, &error);
+	if (!connection) {
+		g_task_return_error (task, error);
+		g_object_unref (task);
+		return;
+	}
+
+	g_variant_builder_init (&platform_data, G_VARIANT_TYPE_VARDICT);
+
+	/* completes the sequence, and lets a running application raise its
+	 * window past focus stealing prevention, on X11 and Wayland */
+	if (activate->startup_id) {
+		g_variant_builder_add (&platform_data, "{sv}", "desktop-startup-id",
+		                       g_variant_new_string (activate->startup_id));
+		g_variant_builder_add (&platform_data, "{sv}", "activation-token",
+		                       g_variant_new_string (activate->startup_id));
+	}
+
+	/* the bus starts the application if it is not running yet */
+	g_dbus_connection_call (connection,
+                            activate->name,
+                            activate->path,
+                            "org.freedesktop.Application",
+                            "Activate",
+                            g_variant_new ("(a{sv})", &platform_data),
+                            NULL,
+                            G_DBUS_CALL_FLAGS_NONE,
+                            -1,
+                            g_task_get_cancellable (task),
+                            activate_call_done_cb,
+                            task);
+
+	g_object_unref (connection);
+}
+
+/* Returns %NULL if @app_info cannot be launched at all. @desktop_id is
+ * the id the catalog knows it by, which an application loaded from a
+ * file outside the XDG data dirs has no other way to get. */
+ApplauncherLaunchPlan *
+applauncher_launch_plan_new (GDesktopAppInfo *app_info,
+                             const gchar     *desktop_id)
+{
+	char **argv = NULL;
+	const char *cmdline;
+	GError *error = NULL;
+	ApplauncherLaunchPlan *plan;
+
+	g_return_val_if_fail (G_IS_DESKTOP_APP_INFO (app_info), NULL);
+
+	cmdline = g_app_info_get_commandline (G_APP_INFO (app_info));
+	gchar *command = g_strdup (cmdline);
+	command = g_strchug (command);
+
+	if (!command || !command[0]) {
+		g_free (command);
+		return NULL;
+	}
+
+	plan = g_slice_new0 (ApplauncherLaunchPlan);
+	plan->desktop_id = g_strdup (desktop_id);
+	plan->command = command;
+	plan->icon_name = g_desktop_app_info_get_string (app_info, G_KEY_FILE_DESKTOP_KEY_ICON);
+	plan->wm_class = g_strdup (g_desktop_app_info_get_startup_wm_class (app_info));
+
+	gchar *disk = g_locale_from_utf8 (command, -1, NULL, NULL, &error);
+	if (!disk) {
+		plan->error = g_strdup (error->message);
+		g_error_free (error);
+		return plan;
+	}
+
+	/* if it's an absolute path or not a URI, it's possibly an executable,
+	 * so try it before displaying it */
+	gchar *scheme = g_uri_parse_scheme (disk);
+	if (g_path_is_absolute (disk) || !scheme) {
+		const gchar *p;
+		GString *string = g_string_sized_new (100);
+
+		for (p = disk; *p != '\0'; ++p) {
+			if (G_UNLIKELY (p[0] == '%' && p[1] != '\0')) {
+				switch (*++p) {
+					case '%':
+						g_string_append_c (string, '%');
+						break;
+						/* skip all the other %? values for now we don't have dnd anyways */
+				}
+			} else {
+				g_string_append_c (string, *p);
+			}
+		}
+
+		if (command_is_executable (string->str, &plan->binary, &argv)) {
+			g_free (argv[0]);
+			argv[0] = g_strdup (plan->binary);
+			plan->argv = argv;
+			plan->working_directory = g_desktop_app_info_get_string (app_info, G_KEY_FILE_DESKTOP_KEY_PATH);
+		}
+
+		g_string_free (string, TRUE);
+	}
+
+	g_free (scheme);
+	g_free (disk);
+
+	if (dbus_name_from_app_info (app_info, desktop_id, &plan->dbus_name, &plan->dbus_path))
+		plan->filename = g_strdup (g_desktop_app_info_get_filename (app_info));
+
+	if (!plan->argv && !plan->dbus_name) {
+		applauncher_launch_plan_free (plan);
+		return NULL;
+	}
+
+	return plan;
+}
+
+void
+applauncher_launch_plan_free (ApplauncherLaunchPlan *plan)
+{
+	if (plan == NULL)
+		return;
+
+	g_free (plan->desktop_id);
+	g_free (plan->command);
+	g_free (plan->binary);
+	g_strfreev (plan->argv);
+	g_free (plan->working_directory);
+	g_free (plan->icon_name);
+	g_free (plan->wm_class);
+	g_free (plan->dbus_name);
+	g_free (plan->dbus_path);
+	g_free (plan->filename);
+	g_free (plan->error);
+
+	g_slice_free (ApplauncherLaunchPlan, plan);
+}
+
+/* Calls org.freedesktop.Application.Activate for a plan with a
+ * dbus_name. An application that is already running only raises its
+ * window; the caller spawns argv if this fails. @startup_id, if not
+ * %NULL, is passed on in the platform data. */
+void
+applauncher_launch_plan_activate (const ApplauncherLaunchPlan *plan,
+                                  const gchar                 *startup_id,
+                                  GCancellable                *cancellable,
+                                  GAsyncReadyCallback          callback,
+                                  gpointer                     user_data)
+{
+	GTask *task;
+	ActivateData *activate;
+
+	g_return_if_fail (plan != NULL && plan->dbus_name != NULL);
+
+	activate = g_slice_new0 (ActivateData);
+	activate->name = g_strdup (plan->dbus_name);
+	activate->path = g_strdup (plan->dbus_path);
+	activate->startup_id = g_strdup (startup_id);
+
+	task = g_task_new (NULL, cancellable, callback, user_data);
+	g_task_set_task_data (task, activate, activate_data_free);
+
+	g_bus_get (G_BUS_TYPE_SESSION, cancellable, activate_bus_ready_cb, task);
+}
+
+gboolean
+applauncher_launch_plan_activate_finish (GAsyncResult  *result,
+                                         GError       **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, NULL), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
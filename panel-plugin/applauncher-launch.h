@@ -0,0 +1,71 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __APPLAUNCHER_LAUNCH_H__
+#define __APPLAUNCHER_LAUNCH_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <gio/gdesktopappinfo.h>
+
+G_BEGIN_DECLS
+
+/* Everything needed to spawn an application, worked out once when the
+ * catalog is built. argv[0] is the absolute path of the binary. argv
+ * may be NULL for an application that can only be D-Bus activated. */
+typedef struct
+{
+	gchar  *desktop_id;
+	gchar  *command;
+	gchar  *binary;
+	gchar **argv;
+	gchar  *working_directory;
+	gchar  *icon_name;
+	gchar  *wm_class;
+
+	/* set by the catalog if another of its entries runs the same binary,
+	 * e.g. with other arguments */
+	gboolean shares_binary;
+
+	/* set for DBusActivatable applications, with the desktop file to
+	 * start a startup-notification sequence from */
+	gchar  *dbus_name;
+	gchar  *dbus_path;
+	gchar  *filename;
+
+	/* set if the Exec line cannot be used, to tell the user on click */
+	gchar  *error;
+} ApplauncherLaunchPlan;
+
+ApplauncherLaunchPlan *applauncher_launch_plan_new  (GDesktopAppInfo       *app_info,
+                                                     const gchar           *desktop_id);
+
+void                   applauncher_launch_plan_free (ApplauncherLaunchPlan *plan);
+
+void                   applauncher_launch_plan_activate        (const ApplauncherLaunchPlan *plan,
+                                                                const gchar                 *startup_id,
+                                                                GCancellable                *cancellable,
+                                                                GAsyncReadyCallback          callback,
+                                                                gpointer                     user_data);
+
+gboolean               applauncher_launch_plan_activate_finish (GAsyncResult                *result,
+                                                                GError                     **error);
+
+G_END_DECLS
+
+#endif /* !__APPLAUNCHER_LAUNCH_H__ */
@@ -25,6 +25,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "xfce-spawn.h"
+#include "applauncher-catalog.h"
+#include "applauncher-favorites.h"
+#include "applauncher-prewarm.h"
+#include "applauncher-tracker.h"
+#include "applauncher-stats.h"
+#include "applauncher-trace.h"
 #include "applauncher-window.h"
 #include "applauncher-plugin.h"
 
@@ -41,6 +48,13 @@
 
 
 #define PANEL_TRAY_ICON_SIZE        (32)
+#define PANEL_TRAY_ICON_NAME        "applauncher-plugin-panel"
+
+/* rendered icons kept, enough for the sizes a slider drag settles on */
+#define TRAY_ICON_CACHE_SIZE        (4)
+
+/* how long the panel size must stay put before rendering a new size */
+#define TRAY_ICON_SETTLE_MS         (150)
 
 
 
@@ -59,6 +73,21 @@ struct _ApplauncherPlugin
 	GtkWidget         *img_tray;
 
 	ApplauncherWindow *popup_window;
+
+	gint64             trace_popup;
+	GdkFrameClock     *first_frame_clock;
+	gulong             first_frame_id;
+
+	gint64             trace_startup;
+	guint              warm_up_id;
+	gboolean           warmed_up;
+
+	/* cairo_surface_t by tray_icon_key(), see tray_icon_update() */
+	GHashTable        *tray_icons;
+	guint              tray_icon_shown;
+	guint              tray_icon_update_id;
+	GtkIconTheme      *icon_theme;
+	gulong             icon_theme_changed_id;
 };
 
 
@@ -72,6 +101,12 @@ on_popup_window_closed (gpointer data)
 	ApplauncherPlugin *plugin = APPLAUNCHER_PLUGIN (data);
 
 	if (plugin->popup_window != NULL) {
+		if (plugin->first_frame_clock != NULL) {
+			g_signal_handler_disconnect (plugin->first_frame_clock, plugin->first_frame_id);
+			g_clear_object (&plugin->first_frame_clock);
+			plugin->first_frame_id = 0;
+		}
+
 		gtk_widget_destroy (GTK_WIDGET (plugin->popup_window));
 		plugin->popup_window = NULL;
 	}
@@ -82,15 +117,140 @@ on_popup_window_closed (gpointer data)
 	return TRUE;
 }
 
+static void
+on_popup_window_first_frame (GdkFrameClock *clock, gpointer data)
+{
+	ApplauncherPlugin *plugin = APPLAUNCHER_PLUGIN (data);
+
+	applauncher_trace_end (plugin->trace_popup, "popup-first-frame");
+	plugin->trace_popup = 0;
+
+	g_signal_handler_disconnect (clock, plugin->first_frame_id);
+	g_clear_object (&plugin->first_frame_clock);
+	plugin->first_frame_id = 0;
+}
+
+static void
+restyle_widget (GtkWidget *widget, gpointer data)
+{
+	GdkRGBA color;
+	GtkStyleContext *context = gtk_widget_get_style_context (widget);
+
+	/* looking a property up makes GTK compute the style right away */
+	gtk_style_context_get_color (context, gtk_style_context_get_state (context), &color);
+
+	if (GTK_IS_CONTAINER (widget))
+		gtk_container_forall (GTK_CONTAINER (widget), restyle_widget, data);
+}
+
+/* How long restyling the whole panel takes, which every style sheet
+ * installed on the screen adds to. */
+static void
+trace_panel_restyle (ApplauncherPlugin *plugin)
+{
+	GtkWidget *toplevel = gtk_widget_get_toplevel (GTK_WIDGET (plugin));
+	gint64 trace;
+
+	if (!applauncher_trace_enabled () || !gtk_widget_is_toplevel (toplevel))
+		return;
+
+	trace = applauncher_trace_begin ();
+	gtk_widget_reset_style (toplevel);
+	restyle_widget (toplevel, NULL);
+	applauncher_trace_end (trace, "panel-restyle");
+}
+
+/* Renders the icons of the favorites the launcher opens on, at the
+ * size it will show them. */
+static void
+prerender_favorites (ApplauncherPlugin *plugin)
+{
+	GdkScreen *screen = gtk_widget_get_screen (GTK_WIDGET (plugin));
+	ApplauncherCatalog *catalog = applauncher_catalog_get_default ();
+
+	applauncher_favorites_prerender (catalog, screen,
+	                                 applauncher_window_suggest_icon_size (screen),
+	                                 gtk_widget_get_scale_factor (GTK_WIDGET (plugin)));
+
+	applauncher_catalog_unref (catalog);
+}
+
+/* Whatever is needed before the first launch but not to show the tray
+ * button: startup notification, window tracking, the catalog and the
+ * icons of the favorites. */
+static void
+warm_up (ApplauncherPlugin *plugin)
+{
+	GdkScreen *screen = gtk_widget_get_screen (GTK_WIDGET (plugin));
+
+	if (plugin->warm_up_id != 0) {
+		g_source_remove (plugin->warm_up_id);
+		plugin->warm_up_id = 0;
+	}
+
+	if (plugin->warmed_up)
+		return;
+	plugin->warmed_up = TRUE;
+
+	xfce_spawn_prepare_screen (screen);
+
+	/* follow running applications to raise them instead of starting again */
+	applauncher_tracker_init (screen);
+
+	applauncher_catalog_unref (applauncher_catalog_get_default ());
+
+	applauncher_favorites_init ();
+	prerender_favorites (plugin);
+
+	applauncher_trace_end (plugin->trace_startup, "panel-to-usable");
+	plugin->trace_startup = 0;
+
+	trace_panel_restyle (plugin);
+}
+
+static gboolean
+warm_up_idle (gpointer data)
+{
+	ApplauncherPlugin *plugin = APPLAUNCHER_PLUGIN (data);
+
+	plugin->warm_up_id = 0;
+	warm_up (plugin);
+
+	return FALSE;
+}
+
+static void
+on_plugin_map (GtkWidget *widget, gpointer data)
+{
+	ApplauncherPlugin *plugin = APPLAUNCHER_PLUGIN (widget);
+
+	g_signal_handlers_disconnect_by_func (widget, on_plugin_map, data);
+
+	/* after the panel has drawn itself */
+	plugin->warm_up_id = g_idle_add_full (G_PRIORITY_LOW, warm_up_idle, plugin, NULL);
+}
+
 static ApplauncherWindow *
 popup_window_new (ApplauncherPlugin *plugin, GdkEventButton *event)
 {
 	GdkScreen *screen;
 	GdkDisplay *display;
 	GdkMonitor *primary;
+	GdkFrameClock *clock;
 	ApplauncherWindow *window;
+	gint64 trace;
+
+	/* clicked before the idle warm-up got to run */
+	warm_up (plugin);
+
+	applauncher_prewarm_notify_activity ();
+
+	/* only those added since the last time, if any */
+	prerender_favorites (plugin);
 
+	trace = applauncher_trace_begin ();
 	window = applauncher_window_new ();
+	applauncher_trace_end (trace, "window-new");
 
 	screen = gtk_widget_get_screen (GTK_WIDGET (plugin));
 	gtk_window_set_screen (GTK_WINDOW (window), gtk_widget_get_screen (GTK_WIDGET (plugin)));
@@ -106,7 +266,18 @@ popup_window_new (ApplauncherPlugin *plugin, GdkEventButton *event)
 
 	gtk_widget_set_size_request (GTK_WIDGET (window),
                                  area.width, area.height - plugin->panel_size);
+
+	trace = applauncher_trace_begin ();
 	gtk_widget_show_all (GTK_WIDGET (window));
+	applauncher_trace_end (trace, "show-all");
+
+	/* icons are loaded while the first frame is laid out and drawn */
+	clock = gtk_widget_get_frame_clock (GTK_WIDGET (window));
+	if (plugin->trace_popup != 0 && clock) {
+		plugin->first_frame_clock = g_object_ref (clock);
+		plugin->first_frame_id = g_signal_connect (clock, "after-paint",
+		                                           G_CALLBACK (on_popup_window_first_frame), plugin);
+	}
 
 	xfce_panel_plugin_block_autohide (XFCE_PANEL_PLUGIN (plugin), TRUE);
 	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (plugin->button), TRUE);
@@ -124,6 +295,7 @@ on_plugin_button_pressed (GtkWidget *widget, GdkEventButton *event, gpointer dat
 			if (plugin->popup_window != NULL) {
 				on_popup_window_closed (plugin);
 			} else {
+				plugin->trace_popup = applauncher_trace_begin ();
 				plugin->popup_window = popup_window_new (plugin, event);
 			}
 
@@ -142,6 +314,123 @@ applauncher_plugin_free_data (XfcePanelPlugin *panel_plugin)
 
     if (plugin->popup_window != NULL)
         on_popup_window_closed (plugin);
+
+    if (plugin->warm_up_id != 0) {
+        g_source_remove (plugin->warm_up_id);
+        plugin->warm_up_id = 0;
+    }
+
+    if (plugin->tray_icon_update_id != 0) {
+        g_source_remove (plugin->tray_icon_update_id);
+        plugin->tray_icon_update_id = 0;
+    }
+
+    g_signal_handler_disconnect (plugin->icon_theme, plugin->icon_theme_changed_id);
+    g_clear_object (&plugin->icon_theme);
+    g_clear_pointer (&plugin->tray_icons, g_hash_table_destroy);
+
+    applauncher_favorites_shutdown ();
+    applauncher_prewarm_shutdown ();
+    applauncher_tracker_shutdown ();
+
+    /* flush the launch stats, and dump them when debugging */
+    applauncher_stats_dump ();
+}
+
+static guint
+tray_icon_key (gint size, gint scale)
+{
+	return ((guint) size << 4) | ((guint) scale & 0xf);
+}
+
+/* Shows the tray icon at the current size, rendering it only if it is
+ * not in the cache already. */
+static void
+tray_icon_update (ApplauncherPlugin *plugin)
+{
+	cairo_surface_t *surface;
+	gint size, scale;
+	guint key;
+	gint64 trace;
+
+	size = plugin->panel_size;
+	scale = gtk_widget_get_scale_factor (GTK_WIDGET (plugin));
+	key = tray_icon_key (size, scale);
+
+	if (key == plugin->tray_icon_shown)
+		return;
+
+	surface = g_hash_table_lookup (plugin->tray_icons, GUINT_TO_POINTER (key));
+	if (surface == NULL) {
+		trace = applauncher_trace_begin ();
+		surface = gtk_icon_theme_load_surface (plugin->icon_theme, PANEL_TRAY_ICON_NAME,
+		                                       size, scale, NULL,
+		                                       GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
+		applauncher_trace_end (trace, "tray-icon-render");
+
+		if (surface == NULL)
+			return;
+
+		if (g_hash_table_size (plugin->tray_icons) >= TRAY_ICON_CACHE_SIZE)
+			g_hash_table_remove_all (plugin->tray_icons);
+		g_hash_table_insert (plugin->tray_icons, GUINT_TO_POINTER (key), surface);
+	}
+
+	gtk_image_set_from_surface (GTK_IMAGE (plugin->img_tray), surface);
+	plugin->tray_icon_shown = key;
+}
+
+static gboolean
+tray_icon_update_timeout (gpointer data)
+{
+	ApplauncherPlugin *plugin = APPLAUNCHER_PLUGIN (data);
+
+	plugin->tray_icon_update_id = 0;
+	tray_icon_update (plugin);
+
+	return FALSE;
+}
+
+/* Cached sizes are shown at once. Others wait for the size to settle,
+ * so dragging the panel size slider renders the icon once, not once
+ * per step; only the very first icon is rendered without waiting. */
+static void
+tray_icon_queue_update (ApplauncherPlugin *plugin)
+{
+	guint key;
+
+	key = tray_icon_key (plugin->panel_size, gtk_widget_get_scale_factor (GTK_WIDGET (plugin)));
+
+	if (plugin->tray_icon_update_id != 0) {
+		g_source_remove (plugin->tray_icon_update_id);
+		plugin->tray_icon_update_id = 0;
+	}
+
+	if (plugin->tray_icon_shown == 0 ||
+	    g_hash_table_contains (plugin->tray_icons, GUINT_TO_POINTER (key))) {
+		tray_icon_update (plugin);
+		return;
+	}
+
+	plugin->tray_icon_update_id = g_timeout_add (TRAY_ICON_SETTLE_MS, tray_icon_update_timeout, plugin);
+}
+
+static void
+on_icon_theme_changed (GtkIconTheme *icon_theme, gpointer data)
+{
+	ApplauncherPlugin *plugin = APPLAUNCHER_PLUGIN (data);
+
+	g_hash_table_remove_all (plugin->tray_icons);
+
+	/* keep the old icon on screen until the new one is rendered */
+	plugin->tray_icon_shown = G_MAXUINT;
+	tray_icon_queue_update (plugin);
+}
+
+static void
+on_plugin_scale_factor_changed (GObject *object, GParamSpec *pspec, gpointer data)
+{
+	tray_icon_queue_update (APPLAUNCHER_PLUGIN (object));
 }
 
 static gboolean
@@ -157,16 +446,7 @@ applauncher_plugin_size_changed (XfcePanelPlugin *panel_plugin, gint size)
 
 	plugin->panel_size = size;
 
-	GdkPixbuf *pix = gtk_icon_theme_load_icon (gtk_icon_theme_get_default (),
-                                               "applauncher-plugin-panel",
-                                               size,
-                                               GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
-
-	if (pix) {
-		gtk_image_set_from_pixbuf (GTK_IMAGE (plugin->img_tray), pix);
-		gtk_image_set_pixel_size (GTK_IMAGE (plugin->img_tray), size);
-		g_object_unref (G_OBJECT (pix));
-	}
+	tray_icon_queue_update (plugin);
 
 	return TRUE;
 }
@@ -180,48 +460,48 @@ applauncher_plugin_mode_changed (XfcePanelPlugin *plugin, XfcePanelPluginMode mo
 static void
 applauncher_plugin_init (ApplauncherPlugin *plugin)
 {
-	gchar *css_path = NULL;
-	GtkCssProvider *provider = NULL;
-
     /* Initialize i18n */
 	setlocale (LC_ALL, "");
 	bindtextdomain (GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR);
 	bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
 	textdomain (GETTEXT_PACKAGE);
 
-	provider = gtk_css_provider_new ();
-	css_path = g_build_filename (PKGDATA_DIR, "theme", "gooroom-applauncher.css", NULL);
-	gtk_css_provider_load_from_path (provider, css_path, NULL);
-	g_free (css_path);
-
-	gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
-                                GTK_STYLE_PROVIDER (provider),
-                                GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-
-	g_object_unref (provider);
+	applauncher_trace_init ();
 
 	plugin->panel_size = 40;
+	plugin->trace_popup = 0;
+	plugin->first_frame_clock = NULL;
+	plugin->first_frame_id = 0;
+	plugin->trace_startup = applauncher_trace_begin ();
+	plugin->warm_up_id = 0;
+	plugin->warmed_up = FALSE;
+	plugin->tray_icons = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                            NULL, (GDestroyNotify) cairo_surface_destroy);
+	plugin->tray_icon_shown = 0;
+	plugin->tray_icon_update_id = 0;
 
 	plugin->button = xfce_panel_create_toggle_button ();
 	xfce_panel_plugin_add_action_widget (XFCE_PANEL_PLUGIN (plugin), plugin->button);
 	gtk_container_add (GTK_CONTAINER (plugin), plugin->button);
 
-	GdkPixbuf *pix;
-	pix = gtk_icon_theme_load_icon (gtk_icon_theme_get_default (),
-                                    "applauncher-plugin-panel",
-                                    PANEL_TRAY_ICON_SIZE,
-                                    GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
-
-	if (pix) {
-		plugin->img_tray = gtk_image_new_from_pixbuf (pix);
-		gtk_image_set_pixel_size (GTK_IMAGE (plugin->img_tray), PANEL_TRAY_ICON_SIZE);
-		gtk_container_add (GTK_CONTAINER (plugin->button), plugin->img_tray);
-		g_object_unref (G_OBJECT (pix));
-	}
+	/* filled in by size-changed, which the panel emits before showing us */
+	plugin->img_tray = gtk_image_new ();
+	gtk_image_set_pixel_size (GTK_IMAGE (plugin->img_tray), PANEL_TRAY_ICON_SIZE);
+	gtk_container_add (GTK_CONTAINER (plugin->button), plugin->img_tray);
+
+	plugin->icon_theme = g_object_ref (gtk_icon_theme_get_default ());
+	plugin->icon_theme_changed_id = g_signal_connect (plugin->icon_theme, "changed",
+	                                                  G_CALLBACK (on_icon_theme_changed), plugin);
+	g_signal_connect (G_OBJECT (plugin), "notify::scale-factor",
+	                  G_CALLBACK (on_plugin_scale_factor_changed), NULL);
 
 	g_signal_connect (G_OBJECT (plugin->button), "button-press-event", G_CALLBACK (on_plugin_button_pressed), plugin);
 
 	gtk_widget_show_all (plugin->button);
+
+	g_signal_connect (G_OBJECT (plugin), "map", G_CALLBACK (on_plugin_map), NULL);
+
+	applauncher_prewarm_init ();
 }
 
 static void
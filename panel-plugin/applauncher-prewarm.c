@@ -0,0 +1,655 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Opt-in pre-warming of the page cache for the most launched
+ * applications. Once the launcher has been left alone for a while and
+ * the machine is not busy, the binaries of the top entries of the
+ * launch stats are read ahead with posix_fadvise(POSIX_FADV_WILLNEED)
+ * from a worker thread, at a limited rate, together with what they
+ * will load: the shared libraries they need, the interpreter and the
+ * exec targets of a wrapper script, and the files of a private install
+ * prefix, such as /usr/lib/libreoffice/program. It stops on I/O
+ * pressure, high load, on battery, or when the "prewarm" key is
+ * switched off. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* for dl_iterate_phdr() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#include <sys/stat.h>
+#ifdef HAVE_LINK_H
+#include <link.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "applauncher-catalog.h"
+#include "applauncher-launch.h"
+#include "applauncher-stats.h"
+#include "applauncher-prewarm.h"
+
+
+#if defined (HAVE_POSIX_FADVISE) && defined (HAVE_LINK_H) && defined (HAVE_DL_ITERATE_PHDR)
+#define USE_PREWARM 1
+#endif
+
+/* start once the launcher has not been used for this long, checking
+ * every PREWARM_POLL_SECONDS */
+#define PREWARM_IDLE_SECONDS  (120)
+#define PREWARM_POLL_SECONDS  (30)
+
+/* and the one minute load average is below this, per processor */
+#define PREWARM_MAX_LOAD      (0.5)
+
+/* number of applications to pre-warm */
+#define PREWARM_APPS          (8)
+
+/* read-ahead budget */
+#define PREWARM_CHUNK         (1024 * 1024)
+#define PREWARM_RATE          (4 * 1024 * 1024)   /* bytes per second */
+#define PREWARM_MAX_FILES     (256)
+
+/* give up above this share of time stalled on I/O (avg10, percent) */
+#define PREWARM_MAX_IO_PRESSURE (10.0)
+
+/* how much of a wrapper script is read for its exec targets */
+#define PREWARM_SCRIPT_MAX    (64 * 1024)
+
+
+static GSettings    *prewarm_settings = NULL;
+static GCancellable *prewarm_cancellable = NULL;
+static guint         prewarm_timeout_id = 0;
+static gint64        prewarm_last_activity = 0;
+
+
+
+#ifdef USE_PREWARM
+static gboolean      prewarm_done = FALSE;
+
+static gboolean
+io_under_pressure (void)
+{
+	gchar *contents = NULL;
+	gchar *avg10;
+	gboolean ret = FALSE;
+
+	if (!g_file_get_contents ("/proc/pressure/io", &contents, NULL, NULL))
+		return FALSE;
+
+	/* some avg10=0.00 avg60=0.00 avg300=0.00 total=0 */
+	avg10 = strstr (contents, "avg10=");
+	if (avg10)
+		ret = g_ascii_strtod (avg10 + strlen ("avg10="), NULL) > PREWARM_MAX_IO_PRESSURE;
+
+	g_free (contents);
+
+	return ret;
+}
+
+static gboolean
+on_battery (void)
+{
+	GDir *dir;
+	const gchar *name;
+	gboolean ret = FALSE;
+
+	dir = g_dir_open ("/sys/class/power_supply", 0, NULL);
+	if (!dir)
+		return FALSE;
+
+	while (!ret && (name = g_dir_read_name (dir)) != NULL) {
+		gchar *path, *status = NULL;
+
+		path = g_build_filename ("/sys/class/power_supply", name, "status", NULL);
+		if (g_file_get_contents (path, &status, NULL, NULL))
+			ret = g_str_has_prefix (status, "Discharging");
+
+		g_free (status);
+		g_free (path);
+	}
+
+	g_dir_close (dir);
+
+	return ret;
+}
+
+static gboolean
+load_too_high (void)
+{
+	gchar *contents = NULL;
+	gboolean ret = FALSE;
+
+	if (!g_file_get_contents ("/proc/loadavg", &contents, NULL, NULL))
+		return FALSE;
+
+	/* 0.12 0.25 0.30 1/234 5678 */
+	ret = g_ascii_strtod (contents, NULL) > PREWARM_MAX_LOAD * g_get_num_processors ();
+
+	g_free (contents);
+
+	return ret;
+}
+
+static gboolean
+should_stop (GCancellable *cancellable)
+{
+	return g_cancellable_is_cancelled (cancellable) || io_under_pressure () ||
+	       load_too_high () || on_battery ();
+}
+
+static int
+add_library_dir (struct dl_phdr_info *info, size_t size, void *data)
+{
+	GPtrArray *dirs = data;
+	gchar *dir;
+	guint i;
+
+	if (!info->dlpi_name || !g_path_is_absolute (info->dlpi_name))
+		return 0;
+
+	dir = g_path_get_dirname (info->dlpi_name);
+	for (i = 0; i < dirs->len; i++) {
+		if (g_strcmp0 (g_ptr_array_index (dirs, i), dir) == 0) {
+			g_free (dir);
+			return 0;
+		}
+	}
+	g_ptr_array_add (dirs, dir);
+
+	return 0;
+}
+
+/* Where the libraries of this process were found is where the dynamic
+ * linker will look for those of the applications too. */
+static GPtrArray *
+get_library_dirs (void)
+{
+	GPtrArray *dirs = g_ptr_array_new_with_free_func (g_free);
+
+	dl_iterate_phdr (add_library_dir, dirs);
+	g_ptr_array_add (dirs, g_strdup ("/lib"));
+	g_ptr_array_add (dirs, g_strdup ("/usr/lib"));
+
+	return dirs;
+}
+
+static gboolean
+read_at (int fd, gpointer buf, gsize len, off_t offset)
+{
+	return (pread (fd, buf, len, offset) == (ssize_t) len);
+}
+
+/* Returns the DT_NEEDED names of a native ELF file, or %NULL. */
+static gchar **
+elf_get_needed (const gchar *path)
+{
+	int fd;
+	guint i;
+	ElfW(Ehdr) ehdr;
+	ElfW(Phdr) *phdrs = NULL;
+	ElfW(Dyn) *dyns = NULL;
+	ElfW(Phdr) *dynamic = NULL;
+	ElfW(Addr) strtab = 0;
+	ElfW(Xword) strsz = 0;
+	gchar *strings = NULL;
+	GPtrArray *needed = NULL;
+	gsize n_dyns;
+
+	fd = g_open (path, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0)
+		return NULL;
+
+	if (!read_at (fd, &ehdr, sizeof (ehdr), 0)
+	    || memcmp (ehdr.e_ident, ELFMAG, SELFMAG) != 0
+	    || ehdr.e_ident[EI_CLASS] != (sizeof (gpointer) == 8 ? ELFCLASS64 : ELFCLASS32)
+	    || ehdr.e_phentsize != sizeof (ElfW(Phdr)))
+		goto out;
+
+	phdrs = g_new (ElfW(Phdr), ehdr.e_phnum);
+	if (!read_at (fd, phdrs, sizeof (ElfW(Phdr)) * ehdr.e_phnum, ehdr.e_phoff))
+		goto out;
+
+	for (i = 0; i < ehdr.e_phnum; i++)
+		if (phdrs[i].p_type == PT_DYNAMIC)
+			dynamic = &phdrs[i];
+
+	if (!dynamic || dynamic->p_filesz > PREWARM_CHUNK)
+		goto out;
+
+	n_dyns = dynamic->p_filesz / sizeof (ElfW(Dyn));
+	dyns = g_new (ElfW(Dyn), n_dyns);
+	if (!read_at (fd, dyns, n_dyns * sizeof (ElfW(Dyn)), dynamic->p_offset))
+		goto out;
+
+	for (i = 0; i < n_dyns && dyns[i].d_tag != DT_NULL; i++) {
+		if (dyns[i].d_tag == DT_STRTAB)
+			strtab = dyns[i].d_un.d_ptr;
+		else if (dyns[i].d_tag == DT_STRSZ)
+			strsz = dyns[i].d_un.d_val;
+	}
+
+	if (strtab == 0 || strsz == 0 || strsz > PREWARM_CHUNK)
+		goto out;
+
+	/* the string table is given as an address, find it in the file */
+	for (i = 0; i < ehdr.e_phnum; i++) {
+		if (phdrs[i].p_type == PT_LOAD
+		    && strtab >= phdrs[i].p_vaddr
+		    && strtab + strsz <= phdrs[i].p_vaddr + phdrs[i].p_filesz) {
+			strings = g_malloc (strsz + 1);
+			if (!read_at (fd, strings, strsz, strtab - phdrs[i].p_vaddr + phdrs[i].p_offset))
+				goto out;
+			strings[strsz] = '\0';
+			break;
+		}
+	}
+
+	if (!strings)
+		goto out;
+
+	needed = g_ptr_array_new ();
+	for (i = 0; i < n_dyns && dyns[i].d_tag != DT_NULL; i++) {
+		if (dyns[i].d_tag == DT_NEEDED && dyns[i].d_un.d_val < strsz)
+			g_ptr_array_add (needed, g_strdup (strings + dyns[i].d_un.d_val));
+	}
+	g_ptr_array_add (needed, NULL);
+
+out:
+	g_free (strings);
+	g_free (dyns);
+	g_free (phdrs);
+	close (fd);
+
+	return needed ? (gchar **) g_ptr_array_free (needed, FALSE) : NULL;
+}
+
+static gchar *
+find_library (GPtrArray *dirs, const gchar *name)
+{
+	guint i;
+
+	if (strchr (name, '/'))
+		return g_strdup (name);
+
+	for (i = 0; i < dirs->len; i++) {
+		gchar *path = g_build_filename (g_ptr_array_index (dirs, i), name, NULL);
+		if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+			return path;
+		g_free (path);
+	}
+
+	return NULL;
+}
+
+static gboolean
+is_system_bin_dir (const gchar *dir)
+{
+	static const gchar *bin_dirs[] = {
+		"/bin", "/sbin", "/usr/bin", "/usr/sbin", "/usr/local/bin", "/usr/local/sbin", "/usr/games"
+	};
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (bin_dirs); i++) {
+		if (g_strcmp0 (dir, bin_dirs[i]) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static void
+push_executable (GQueue *queue, const gchar *path)
+{
+	if (g_file_test (path, G_FILE_TEST_IS_REGULAR) && g_file_test (path, G_FILE_TEST_IS_EXECUTABLE))
+		g_queue_push_tail (queue, g_strdup (path));
+}
+
+/* Queues what a wrapper script will run: its interpreter, resolved
+ * through env if need be, and every absolute path to an executable it
+ * mentions, which is how "exec /usr/lib/firefox/firefox" is found. */
+static void
+script_push_targets (const gchar *path, GQueue *queue)
+{
+	int fd;
+	ssize_t len;
+	gchar *script, *line_end, *shebang, **tokens;
+	guint i;
+
+	fd = g_open (path, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0)
+		return;
+
+	script = g_malloc (PREWARM_SCRIPT_MAX + 1);
+	len = read (fd, script, PREWARM_SCRIPT_MAX);
+	close (fd);
+
+	if (len < 2 || script[0] != '#' || script[1] != '!') {
+		g_free (script);
+		return;
+	}
+	script[len] = '\0';
+
+	/* #!/usr/bin/env python3 */
+	line_end = strchr (script, '\n');
+	shebang = g_strndup (script + 2, line_end ? line_end - script - 2 : len - 2);
+	tokens = g_strsplit_set (shebang, " \t", -1);
+	g_free (shebang);
+	for (i = 0; tokens[i] != NULL && tokens[i][0] == '\0'; i++);
+	if (tokens[i] != NULL) {
+		push_executable (queue, tokens[i]);
+
+		if (g_str_has_suffix (tokens[i], "/env")) {
+			for (i++; tokens[i] != NULL && (tokens[i][0] == '\0' || tokens[i][0] == '-'); i++);
+			if (tokens[i] != NULL) {
+				gchar *program = g_find_program_in_path (tokens[i]);
+				if (program)
+					g_queue_push_tail (queue, program);
+			}
+		}
+	}
+	g_strfreev (tokens);
+
+	tokens = g_strsplit_set (line_end ? line_end : "", " \t\n\"'`;|&()=", -1);
+	for (i = 0; tokens[i] != NULL; i++) {
+		if (tokens[i][0] == '/')
+			push_executable (queue, tokens[i]);
+	}
+	g_strfreev (tokens);
+
+	g_free (script);
+}
+
+/* Queues the regular files of @dir, for an application installed in a
+ * directory of its own: most of what it loads at start is there, and
+ * not in its DT_NEEDED entries. */
+static void
+prefix_push_files (const gchar *dir, GQueue *queue)
+{
+	GDir *gdir;
+	const gchar *name;
+
+	gdir = g_dir_open (dir, 0, NULL);
+	if (!gdir)
+		return;
+
+	while ((name = g_dir_read_name (gdir)) != NULL) {
+		gchar *path = g_build_filename (dir, name, NULL);
+
+		if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+			g_queue_push_tail (queue, path);
+		else
+			g_free (path);
+	}
+
+	g_dir_close (gdir);
+}
+
+/* Requests read-ahead of @path a chunk at a time, sleeping in between
+ * to stay within PREWARM_RATE. */
+static gboolean
+warm_file (const gchar *path, GCancellable *cancellable)
+{
+	int fd;
+	off_t offset;
+	struct stat st;
+
+	fd = g_open (path, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0)
+		return TRUE;
+
+	if (fstat (fd, &st) == 0) {
+		for (offset = 0; offset < st.st_size; offset += PREWARM_CHUNK) {
+			if (g_cancellable_is_cancelled (cancellable))
+				break;
+
+			posix_fadvise (fd, offset, PREWARM_CHUNK, POSIX_FADV_WILLNEED);
+			g_usleep ((G_USEC_PER_SEC / (PREWARM_RATE / PREWARM_CHUNK)));
+		}
+	}
+
+	close (fd);
+
+	return !g_cancellable_is_cancelled (cancellable);
+}
+
+static void
+prewarm_thread (GTask        *task,
+                gpointer      source_object,
+                gpointer      task_data,
+                GCancellable *cancellable)
+{
+	GQueue queue = G_QUEUE_INIT;
+	GHashTable *visited, *prefixes;
+	GPtrArray *dirs;
+	gchar **binaries = task_data;
+	gchar *path;
+	guint i, n_files = 0;
+
+	dirs = get_library_dirs ();
+	visited = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	prefixes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	for (i = 0; binaries[i] != NULL; i++)
+		g_queue_push_tail (&queue, g_strdup (binaries[i]));
+
+	while ((path = g_queue_pop_head (&queue)) != NULL) {
+		gchar **needed, *real, *dir;
+
+		/* /usr/bin/libreoffice is a link into the install prefix */
+		real = realpath (path, NULL);
+		if (real) {
+			g_free (path);
+			path = g_strdup (real);
+			free (real);
+		}
+
+		if (g_hash_table_contains (visited, path)) {
+			g_free (path);
+			continue;
+		}
+		g_hash_table_add (visited, path);
+
+		if (n_files++ >= PREWARM_MAX_FILES || should_stop (cancellable)
+		    || !warm_file (path, cancellable))
+			break;
+
+		needed = elf_get_needed (path);
+		for (i = 0; needed && needed[i] != NULL; i++) {
+			gchar *library = find_library (dirs, needed[i]);
+			if (library)
+				g_queue_push_tail (&queue, library);
+		}
+
+		/* not ELF, or at least not a dynamic one */
+		if (!needed)
+			script_push_targets (path, &queue);
+		g_strfreev (needed);
+
+		/* only the binaries themselves open a prefix, not its files */
+		dir = g_path_get_dirname (path);
+		if (g_file_test (path, G_FILE_TEST_IS_EXECUTABLE) && !is_system_bin_dir (dir)
+		    && !g_str_has_suffix (path, ".so") && strstr (path, ".so.") == NULL
+		    && !g_hash_table_contains (prefixes, dir)) {
+			prefix_push_files (dir, &queue);
+			g_hash_table_add (prefixes, dir);
+		} else {
+			g_free (dir);
+		}
+	}
+
+	g_queue_free_full (&queue, g_free);
+	g_hash_table_destroy (prefixes);
+	g_hash_table_destroy (visited);
+	g_ptr_array_unref (dirs);
+
+	g_task_return_boolean (task, TRUE);
+}
+
+typedef struct
+{
+	guint        launches;
+	const gchar *binary;
+} PrewarmCandidate;
+
+static gint
+compare_candidates (gconstpointer a, gconstpointer b)
+{
+	const PrewarmCandidate *ca = a;
+	const PrewarmCandidate *cb = b;
+
+	return (ca->launches < cb->launches) - (ca->launches > cb->launches);
+}
+
+/* The binaries of the most launched applications, most launched first. */
+static gchar **
+get_top_binaries (void)
+{
+	guint i;
+	GArray *candidates;
+	GPtrArray *binaries;
+	ApplauncherCatalog *catalog;
+
+	catalog = applauncher_catalog_get_default ();
+	candidates = g_array_new (FALSE, FALSE, sizeof (PrewarmCandidate));
+
+	for (i = 0; i < applauncher_catalog_get_n_entries (catalog); i++) {
+		const ApplauncherLaunchPlan *plan = applauncher_catalog_get_launch_plan (catalog, i);
+		PrewarmCandidate candidate;
+
+		if (!plan || !plan->desktop_id || !plan->binary)
+			continue;
+
+		candidate.launches = applauncher_stats_get_launches (plan->desktop_id);
+		candidate.binary = plan->binary;
+		if (candidate.launches > 0)
+			g_array_append_val (candidates, candidate);
+	}
+
+	g_array_sort (candidates, compare_candidates);
+
+	binaries = g_ptr_array_new ();
+	for (i = 0; i < MIN (candidates->len, PREWARM_APPS); i++)
+		g_ptr_array_add (binaries, g_strdup (g_array_index (candidates, PrewarmCandidate, i).binary));
+	g_ptr_array_add (binaries, NULL);
+
+	g_array_free (candidates, TRUE);
+	applauncher_catalog_unref (catalog);
+
+	return (gchar **) g_ptr_array_free (binaries, FALSE);
+}
+
+/* Polls for the launcher to have been left alone long enough, on a
+ * machine with little else to do. */
+static gboolean
+prewarm_timeout (gpointer data)
+{
+	GTask *task;
+
+	if (g_get_monotonic_time () - prewarm_last_activity < PREWARM_IDLE_SECONDS * G_USEC_PER_SEC
+	    || load_too_high ())
+		return TRUE;
+
+	prewarm_timeout_id = 0;
+	prewarm_done = TRUE;
+
+	prewarm_cancellable = g_cancellable_new ();
+
+	task = g_task_new (NULL, prewarm_cancellable, NULL, NULL);
+	g_task_set_task_data (task, get_top_binaries (), (GDestroyNotify) g_strfreev);
+	g_task_run_in_thread (task, prewarm_thread);
+	g_object_unref (task);
+
+	return FALSE;
+}
+#endif
+
+static void
+prewarm_stop (void)
+{
+	if (prewarm_timeout_id != 0) {
+		g_source_remove (prewarm_timeout_id);
+		prewarm_timeout_id = 0;
+	}
+
+	if (prewarm_cancellable) {
+		g_cancellable_cancel (prewarm_cancellable);
+		g_clear_object (&prewarm_cancellable);
+	}
+}
+
+static void
+prewarm_changed_cb (GSettings   *settings,
+                    const gchar *key,
+                    gpointer     data)
+{
+	prewarm_stop ();
+
+#ifdef USE_PREWARM
+	/* one run per session, like a login would */
+	if (g_settings_get_boolean (settings, "prewarm") && !prewarm_done)
+		prewarm_timeout_id = g_timeout_add_seconds (PREWARM_POLL_SECONDS, prewarm_timeout, NULL);
+#endif
+}
+
+void
+applauncher_prewarm_init (void)
+{
+	if (prewarm_settings)
+		return;
+
+	prewarm_last_activity = g_get_monotonic_time ();
+
+	prewarm_settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	g_signal_connect (prewarm_settings, "changed::prewarm",
+	                  G_CALLBACK (prewarm_changed_cb), NULL);
+
+	prewarm_changed_cb (prewarm_settings, "prewarm", NULL);
+}
+
+/* Called whenever the launcher is used, which puts pre-warming off. */
+void
+applauncher_prewarm_notify_activity (void)
+{
+	prewarm_last_activity = g_get_monotonic_time ();
+}
+
+void
+applauncher_prewarm_shutdown (void)
+{
+	prewarm_stop ();
+	g_clear_object (&prewarm_settings);
+}
@@ -0,0 +1,201 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Checks that search-as-you-type allocates nothing per keystroke once
+ * its buffers have grown to fit: the same keystrokes are typed again
+ * with every call into the allocator counted, on the worker thread as
+ * well as on this one. Built and run by "make check". */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "applauncher-catalog.h"
+#include "applauncher-search.h"
+#include "applauncher-test-menu.h"
+
+
+#define TEST_N_APPS   (200)
+#define TEST_SKIP     (77)    /* what automake takes for a skipped test */
+
+static const gchar *test_queries[] = { "bench-app-00042", "bench application 1", "" };
+
+
+
+#ifdef __GLIBC__
+/* glibc's own entry points, which the definitions below forward to */
+extern void *__libc_malloc   (size_t size);
+extern void *__libc_calloc   (size_t n_members, size_t size);
+extern void *__libc_realloc  (void *ptr, size_t size);
+extern void *__libc_memalign (size_t alignment, size_t size);
+extern void  __libc_free     (void *ptr);
+
+static volatile gint counting = 0;
+static volatile gint n_allocs = 0;
+
+#define COUNT_ALLOC() \
+	G_STMT_START { if (g_atomic_int_get (&counting)) g_atomic_int_inc (&n_allocs); } G_STMT_END
+
+void *
+malloc (size_t size)
+{
+	COUNT_ALLOC ();
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n_members, size_t size)
+{
+	COUNT_ALLOC ();
+	return __libc_calloc (n_members, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	COUNT_ALLOC ();
+	return __libc_realloc (ptr, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+	COUNT_ALLOC ();
+	return __libc_memalign (alignment, size);
+}
+
+void *
+aligned_alloc (size_t alignment, size_t size)
+{
+	COUNT_ALLOC ();
+	return __libc_memalign (alignment, size);
+}
+
+int
+posix_memalign (void **ptr, size_t alignment, size_t size)
+{
+	void *p;
+
+	COUNT_ALLOC ();
+	p = __libc_memalign (alignment, size);
+	if (!p)
+		return ENOMEM;
+
+	*ptr = p;
+	return 0;
+}
+
+void
+free (void *ptr)
+{
+	__libc_free (ptr);
+}
+#endif
+
+static void
+test_search_done_cb (ApplauncherSearch *search,
+                     const GArray      *matches,
+                     gpointer           data)
+{
+	guint *n_results = data;
+
+	(*n_results)++;
+}
+
+/* Types each query a character at a time, then deletes it again, and
+ * waits for the results of every keystroke. */
+static void
+test_type (ApplauncherSearch *search, guint *n_results, gchar *buffer)
+{
+	guint q, len, n;
+	gint step;
+
+	for (q = 0; q < G_N_ELEMENTS (test_queries); q++) {
+		n = strlen (test_queries[q]);
+
+		for (step = -(gint) n; step <= (gint) n; step++) {
+			guint before = *n_results;
+
+			len = n - ABS (step);
+			memcpy (buffer, test_queries[q], len);
+			buffer[len] = '\0';
+
+			applauncher_search_query (search, buffer);
+			while (*n_results == before)
+				g_main_context_iteration (NULL, TRUE);
+		}
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	gchar *dir, *menu_file = NULL;
+	gchar buffer[64];
+	ApplauncherCatalog *catalog;
+	ApplauncherSearch *search;
+	guint n_results = 0;
+	int ret = 0;
+
+#ifndef __GLIBC__
+	g_printerr ("applauncher-search-test: allocations can only be counted with glibc\n");
+	return TEST_SKIP;
+#else
+	dir = g_dir_make_tmp ("applauncher-test-XXXXXX", NULL);
+	if (!dir)
+		return TEST_SKIP;
+
+	if (!applauncher_test_write_menu (dir, TEST_N_APPS, FALSE, &menu_file)) {
+		applauncher_test_remove_tree (dir);
+		return TEST_SKIP;
+	}
+
+	catalog = applauncher_catalog_new (menu_file, NULL, NULL);
+	search = applauncher_search_new (catalog, test_search_done_cb, &n_results);
+
+	/* twice, for every buffer to have grown to its largest */
+	test_type (search, &n_results, buffer);
+	test_type (search, &n_results, buffer);
+
+	g_atomic_int_set (&counting, 1);
+	test_type (search, &n_results, buffer);
+	g_atomic_int_set (&counting, 0);
+
+	if (g_atomic_int_get (&n_allocs) != 0) {
+		g_printerr ("applauncher-search-test: %d allocations while typing\n",
+		            g_atomic_int_get (&n_allocs));
+		ret = 1;
+	}
+
+	applauncher_search_free (search);
+	applauncher_catalog_unref (catalog);
+
+	applauncher_test_remove_tree (dir);
+	g_free (menu_file);
+	g_free (dir);
+
+	return ret;
+#endif
+}
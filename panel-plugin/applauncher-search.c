@@ -0,0 +1,258 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Search-as-you-type on one long-lived worker thread. Every buffer,
+ * the cancellable and the source the results come back through are
+ * made once, with the search, and reused from one query to the next,
+ * so that once they have grown to fit a keystroke allocates nothing:
+ * no task, no thread pool job, no copy of the text.
+ *
+ * A query replaces the one before it. If the worker is still busy with
+ * that one, it is cancelled, and only the results of the newest query
+ * are ever handed to the callback, on the main context the search was
+ * made in. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "applauncher-arena.h"
+#include "applauncher-trace.h"
+#include "applauncher-search.h"
+
+
+typedef struct
+{
+	GSource            source;
+	ApplauncherSearch *search;
+} SearchSource;
+
+struct _ApplauncherSearch
+{
+	ApplauncherCatalog    *catalog;
+	ApplauncherSearchFunc  func;
+	gpointer               user_data;
+
+	GThread               *thread;
+	GSource               *source;   /* made ready when results are in */
+
+	/* everything below is under the lock */
+	GMutex                 lock;
+	GCond                  cond;
+	gboolean               quit;
+	gboolean               busy;
+	GCancellable          *cancellable;
+
+	GString               *pending;  /* the newest query */
+	gboolean               has_pending;
+	guint                  generation;
+
+	GArray                *done;     /* results of done_generation */
+	guint                  done_generation;
+	gboolean               has_done;
+
+	/* owned by the worker */
+	GString               *text;
+	GArray                *work;
+	ApplauncherArena      *arena;
+
+	/* owned by the main context, handed to the callback */
+	GArray                *shown;
+};
+
+
+
+static GArray *
+search_array_new (ApplauncherCatalog *catalog)
+{
+	return g_array_sized_new (FALSE, FALSE, sizeof (guint),
+	                          applauncher_catalog_get_n_entries (catalog));
+}
+
+static gpointer
+search_thread (gpointer data)
+{
+	ApplauncherSearch *search = data;
+	GArray *swap;
+	gboolean found;
+	gint64 trace;
+	guint generation;
+
+	g_mutex_lock (&search->lock);
+	while (TRUE) {
+		while (!search->has_pending && !search->quit)
+			g_cond_wait (&search->cond, &search->lock);
+
+		if (search->quit)
+			break;
+
+		g_string_assign (search->text, search->pending->str);
+		generation = search->generation;
+		search->has_pending = FALSE;
+		search->busy = TRUE;
+		g_mutex_unlock (&search->lock);
+
+		trace = applauncher_trace_begin ();
+		applauncher_arena_reset (search->arena);
+		found = applauncher_catalog_search_into (search->catalog, search->text->str,
+		                                         search->arena, search->work,
+		                                         search->cancellable);
+		if (found)
+			applauncher_trace_end (trace, "search");
+
+		g_mutex_lock (&search->lock);
+		search->busy = FALSE;
+		g_cancellable_reset (search->cancellable);
+
+		if (found && generation == search->generation) {
+			swap = search->done;
+			search->done = search->work;
+			search->work = swap;
+			search->done_generation = generation;
+			search->has_done = TRUE;
+			g_source_set_ready_time (search->source, 0);
+		}
+	}
+	g_mutex_unlock (&search->lock);
+
+	return NULL;
+}
+
+static gboolean
+search_source_dispatch (GSource     *source,
+                        GSourceFunc  callback,
+                        gpointer     data)
+{
+	ApplauncherSearch *search = ((SearchSource *) source)->search;
+	GArray *swap;
+	gboolean newest;
+
+	g_source_set_ready_time (source, -1);
+
+	g_mutex_lock (&search->lock);
+	newest = search->has_done && search->done_generation == search->generation;
+	if (newest) {
+		swap = search->shown;
+		search->shown = search->done;
+		search->done = swap;
+	}
+	search->has_done = FALSE;
+	g_mutex_unlock (&search->lock);
+
+	/* otherwise a newer query is on its way */
+	if (newest)
+		search->func (search, search->shown, search->user_data);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs search_source_funcs = {
+	NULL, NULL, search_source_dispatch, NULL
+};
+
+ApplauncherSearch *
+applauncher_search_new (ApplauncherCatalog    *catalog,
+                        ApplauncherSearchFunc  func,
+                        gpointer               user_data)
+{
+	ApplauncherSearch *search;
+
+	g_return_val_if_fail (catalog != NULL, NULL);
+	g_return_val_if_fail (func != NULL, NULL);
+
+	search = g_slice_new0 (ApplauncherSearch);
+	search->catalog = applauncher_catalog_ref (catalog);
+	search->func = func;
+	search->user_data = user_data;
+
+	g_mutex_init (&search->lock);
+	g_cond_init (&search->cond);
+	search->cancellable = g_cancellable_new ();
+
+	search->pending = g_string_sized_new (64);
+	search->text = g_string_sized_new (64);
+	search->arena = applauncher_arena_new (1024);
+	search->work = search_array_new (catalog);
+	search->done = search_array_new (catalog);
+	search->shown = search_array_new (catalog);
+
+	/* same priority as a GTask callback had */
+	search->source = g_source_new (&search_source_funcs, sizeof (SearchSource));
+	((SearchSource *) search->source)->search = search;
+	g_source_set_name (search->source, "applauncher-search");
+	g_source_attach (search->source, g_main_context_get_thread_default ());
+
+	search->thread = g_thread_new ("applauncher-search", search_thread, search);
+
+	return search;
+}
+
+void
+applauncher_search_free (ApplauncherSearch *search)
+{
+	if (search == NULL)
+		return;
+
+	g_mutex_lock (&search->lock);
+	search->quit = TRUE;
+	g_cancellable_cancel (search->cancellable);
+	g_cond_signal (&search->cond);
+	g_mutex_unlock (&search->lock);
+
+	g_thread_join (search->thread);
+
+	g_source_destroy (search->source);
+	g_source_unref (search->source);
+
+	g_object_unref (search->cancellable);
+	g_mutex_clear (&search->lock);
+	g_cond_clear (&search->cond);
+
+	g_string_free (search->pending, TRUE);
+	g_string_free (search->text, TRUE);
+	applauncher_arena_free (search->arena);
+	g_array_unref (search->work);
+	g_array_unref (search->done);
+	g_array_unref (search->shown);
+
+	applauncher_catalog_unref (search->catalog);
+
+	g_slice_free (ApplauncherSearch, search);
+}
+
+/* Searches for @text, giving up on any query still running. */
+void
+applauncher_search_query (ApplauncherSearch *search,
+                          const gchar       *text)
+{
+	g_return_if_fail (search != NULL);
+
+	g_mutex_lock (&search->lock);
+	g_string_assign (search->pending, text ? text : "");
+	search->has_pending = TRUE;
+	search->generation++;
+
+	if (search->busy)
+		g_cancellable_cancel (search->cancellable);
+
+	g_cond_signal (&search->cond);
+	g_mutex_unlock (&search->lock);
+}
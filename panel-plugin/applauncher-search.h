@@ -0,0 +1,46 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef __APPLAUNCHER_SEARCH_H__
+#define __APPLAUNCHER_SEARCH_H__
+
+#include <glib.h>
+
+#include "applauncher-catalog.h"
+
+G_BEGIN_DECLS
+
+typedef struct _ApplauncherSearch ApplauncherSearch;
+
+/* @matches is only valid until the callback returns */
+typedef void (*ApplauncherSearchFunc) (ApplauncherSearch *search,
+                                       const GArray      *matches,
+                                       gpointer           user_data);
+
+ApplauncherSearch *applauncher_search_new   (ApplauncherCatalog    *catalog,
+                                             ApplauncherSearchFunc  func,
+                                             gpointer               user_data);
+
+void               applauncher_search_free  (ApplauncherSearch     *search);
+
+void               applauncher_search_query (ApplauncherSearch     *search,
+                                             const gchar           *text);
+
+G_END_DECLS
+
+#endif /* !__APPLAUNCHER_SEARCH_H__ */
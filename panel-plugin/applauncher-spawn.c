@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* A replacement for g_spawn_async() built on posix_spawn(). glibc
+ * implements it with clone(CLONE_VM|CLONE_VFORK), so the address space
+ * of the panel is never duplicated, and the inherited descriptors are
+ * dropped with a single closefrom() file action instead of a loop over
+ * every possible fd in the child. Requests posix_spawn() cannot serve
+ * on this system go through g_spawn_async() unchanged. Setting
+ * APPLAUNCHER_SPAWN_FORK in the environment forces the fallback. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SPAWN_H
+#include <spawn.h>
+#endif
+#ifdef HAVE_CRT_EXTERNS_H
+#include <crt_externs.h> /* for _NSGetEnviron */
+#endif
+
+#include <glib.h>
+#include <glib/gi18n.h>
+
+#include "applauncher-spawn.h"
+
+#ifdef HAVE__NSGETENVIRON
+#define environ (*_NSGetEnviron())
+#elif !HAVE_DECL_ENVIRON
+extern gchar **environ;
+#endif
+
+#if defined (HAVE_SPAWN_H) && defined (HAVE_POSIX_SPAWN) \
+    && defined (HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCLOSEFROM_NP)
+#define USE_POSIX_SPAWN 1
+#endif
+
+
+
+#ifdef USE_POSIX_SPAWN
+static GSpawnError
+spawn_error_from_errno (gint err)
+{
+	switch (err)
+	{
+		case EACCES:
+			return G_SPAWN_ERROR_ACCES;
+		case EPERM:
+			return G_SPAWN_ERROR_PERM;
+		case E2BIG:
+			return G_SPAWN_ERROR_TOO_BIG;
+		case ENOEXEC:
+			return G_SPAWN_ERROR_NOEXEC;
+		case ENAMETOOLONG:
+			return G_SPAWN_ERROR_NAMETOOLONG;
+		case ENOENT:
+			return G_SPAWN_ERROR_NOENT;
+		case ENOMEM:
+			return G_SPAWN_ERROR_NOMEM;
+		case ENOTDIR:
+			return G_SPAWN_ERROR_NOTDIR;
+		case ELOOP:
+			return G_SPAWN_ERROR_LOOP;
+		case ETXTBSY:
+			return G_SPAWN_ERROR_TXTBUSY;
+		case EIO:
+			return G_SPAWN_ERROR_IO;
+		case ENFILE:
+			return G_SPAWN_ERROR_NFILE;
+		case EMFILE:
+			return G_SPAWN_ERROR_MFILE;
+		case EINVAL:
+			return G_SPAWN_ERROR_INVAL;
+		case EISDIR:
+			return G_SPAWN_ERROR_ISDIR;
+		default:
+			return G_SPAWN_ERROR_FAILED;
+	}
+}
+
+static gboolean
+can_use_posix_spawn (const gchar *working_directory, GSpawnFlags flags)
+{
+	/* without a double fork the caller has to reap the child */
+	if (!(flags & G_SPAWN_DO_NOT_REAP_CHILD))
+		return FALSE;
+
+	if (flags & ~(G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_SEARCH_PATH))
+		return FALSE;
+
+#ifndef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+	if (working_directory != NULL)
+		return FALSE;
+#endif
+
+	return (g_getenv ("APPLAUNCHER_SPAWN_FORK") == NULL);
+}
+
+static gboolean
+spawn_posix (const gchar  *working_directory,
+             gchar       **argv,
+             gchar       **envp,
+             GSpawnFlags   flags,
+             GPid         *child_pid,
+             GError      **error)
+{
+	gint ret;
+	pid_t pid;
+	sigset_t mask;
+	posix_spawnattr_t attr;
+	posix_spawn_file_actions_t actions;
+
+	posix_spawnattr_init (&attr);
+	posix_spawn_file_actions_init (&actions);
+
+	/* the child starts with no blocked signals and a default SIGPIPE */
+	sigemptyset (&mask);
+	posix_spawnattr_setsigmask (&attr, &mask);
+	sigaddset (&mask, SIGPIPE);
+	posix_spawnattr_setsigdefault (&attr, &mask);
+	posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+#ifdef HAVE_POSIX_SPAWN_FILE_ACTIONS_ADDCHDIR_NP
+	if (working_directory != NULL)
+		posix_spawn_file_actions_addchdir_np (&actions, working_directory);
+#endif
+
+	/* keep stdin, stdout and stderr like g_spawn_async() does */
+	posix_spawn_file_actions_addclosefrom_np (&actions, 3);
+
+	if (envp == NULL)
+		envp = (gchar **) environ;
+
+	if (flags & G_SPAWN_SEARCH_PATH)
+		ret = posix_spawnp (&pid, argv[0], &actions, &attr, argv, envp);
+	else
+		ret = posix_spawn (&pid, argv[0], &actions, &attr, argv, envp);
+
+	posix_spawn_file_actions_destroy (&actions);
+	posix_spawnattr_destroy (&attr);
+
+	if (ret != 0) {
+		g_set_error (error, G_SPAWN_ERROR, spawn_error_from_errno (ret),
+		             _("Failed to execute child process \"%s\" (%s)"),
+		             argv[0], g_strerror (ret));
+		return FALSE;
+	}
+
+	if (child_pid != NULL)
+		*child_pid = pid;
+
+	return TRUE;
+}
+#endif
+
+gboolean
+applauncher_spawn_async (const gchar  *working_directory,
+                         gchar       **argv,
+                         gchar       **envp,
+                         GSpawnFlags   flags,
+                         GPid         *child_pid,
+                         GError      **error)
+{
+	g_return_val_if_fail (argv != NULL && argv[0] != NULL, FALSE);
+	g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+#ifdef USE_POSIX_SPAWN
+	if (can_use_posix_spawn (working_directory, flags))
+		return spawn_posix (working_directory, argv, envp, flags, child_pid, error);
+#endif
+
+	return g_spawn_async (working_directory, argv, envp, flags,
+	                      NULL, NULL, child_pid, error);
+}
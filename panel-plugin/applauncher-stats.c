@@ -0,0 +1,185 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Launch telemetry per desktop id: time from the click to the exec of
+ * the child, and from the exec to the end of its startup notification
+ * sequence. Totals are kept in a key file in the user cache directory
+ * so they add up across sessions. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "applauncher-latency.h"
+#include "applauncher-stats.h"
+
+
+/* write the file at most this often */
+#define SAVE_DELAY_SECONDS    (5)
+
+#define KEY_LAUNCHES          "launches"
+#define KEY_EXEC_TOTAL        "exec-total-ms"
+#define KEY_EXEC_MAX          "exec-max-ms"
+#define KEY_READY_COUNT       "ready-count"
+#define KEY_READY_TOTAL       "ready-total-ms"
+#define KEY_READY_MAX         "ready-max-ms"
+
+
+static GKeyFile *stats = NULL;
+static gchar    *stats_path = NULL;
+static guint     save_id = 0;
+
+
+
+static GKeyFile *
+stats_get (void)
+{
+	if (G_UNLIKELY (stats == NULL)) {
+		stats_path = g_build_filename (g_get_user_cache_dir (),
+		                               "gooroom-applauncher-plugin",
+		                               "launch-stats", NULL);
+		stats = g_key_file_new ();
+		g_key_file_load_from_file (stats, stats_path, G_KEY_FILE_NONE, NULL);
+	}
+
+	return stats;
+}
+
+static gboolean
+stats_save (gpointer data)
+{
+	gchar *dir, *contents;
+	gsize length;
+
+	save_id = 0;
+
+	if (stats == NULL)
+		return FALSE;
+
+	dir = g_path_get_dirname (stats_path);
+	if (g_mkdir_with_parents (dir, 0700) == 0) {
+		contents = g_key_file_to_data (stats, &length, NULL);
+		g_file_set_contents (stats_path, contents, length, NULL);
+		g_free (contents);
+	}
+	g_free (dir);
+
+	return FALSE;
+}
+
+static void
+stats_add (GKeyFile    *keyfile,
+           const gchar *group,
+           const gchar *total_key,
+           const gchar *max_key,
+           gdouble      ms)
+{
+	gdouble total = g_key_file_get_double (keyfile, group, total_key, NULL);
+	gdouble max = g_key_file_get_double (keyfile, group, max_key, NULL);
+
+	g_key_file_set_double (keyfile, group, total_key, total + ms);
+	g_key_file_set_double (keyfile, group, max_key, MAX (max, ms));
+}
+
+/* @ready_usec is negative if the application never completed its
+ * startup sequence. */
+void
+applauncher_stats_record (const gchar *desktop_id,
+                          gint64       exec_usec,
+                          gint64       ready_usec)
+{
+	GKeyFile *keyfile;
+	gint launches;
+
+	g_return_if_fail (desktop_id != NULL);
+
+	keyfile = stats_get ();
+
+	launches = g_key_file_get_integer (keyfile, desktop_id, KEY_LAUNCHES, NULL);
+	g_key_file_set_integer (keyfile, desktop_id, KEY_LAUNCHES, launches + 1);
+	stats_add (keyfile, desktop_id, KEY_EXEC_TOTAL, KEY_EXEC_MAX, exec_usec / 1000.0);
+
+	if (ready_usec >= 0) {
+		gint count = g_key_file_get_integer (keyfile, desktop_id, KEY_READY_COUNT, NULL);
+		g_key_file_set_integer (keyfile, desktop_id, KEY_READY_COUNT, count + 1);
+		stats_add (keyfile, desktop_id, KEY_READY_TOTAL, KEY_READY_MAX, ready_usec / 1000.0);
+	}
+
+	if (applauncher_latency_enabled ()) {
+		if (ready_usec >= 0)
+			applauncher_latency_log ("launch %s: click-to-exec=%.1f ms exec-to-ready=%.1f ms",
+			                         desktop_id, exec_usec / 1000.0, ready_usec / 1000.0);
+		else
+			applauncher_latency_log ("launch %s: click-to-exec=%.1f ms exec-to-ready=n/a",
+			                         desktop_id, exec_usec / 1000.0);
+	}
+
+	if (save_id == 0)
+		save_id = g_timeout_add_seconds (SAVE_DELAY_SECONDS, stats_save, NULL);
+}
+
+guint
+applauncher_stats_get_launches (const gchar *desktop_id)
+{
+	g_return_val_if_fail (desktop_id != NULL, 0);
+
+	return MAX (0, g_key_file_get_integer (stats_get (), desktop_id, KEY_LAUNCHES, NULL));
+}
+
+/* Averages of every application launched so far, written to the
+ * latency log. Also flushes pending changes to the stats file. */
+void
+applauncher_stats_dump (void)
+{
+	gsize i, n_groups;
+	gchar **groups;
+	GKeyFile *keyfile;
+
+	if (save_id != 0) {
+		g_source_remove (save_id);
+		stats_save (NULL);
+	}
+
+	if (!applauncher_latency_enabled ())
+		return;
+
+	keyfile = stats_get ();
+	groups = g_key_file_get_groups (keyfile, &n_groups);
+
+	for (i = 0; i < n_groups; i++) {
+		gint launches = g_key_file_get_integer (keyfile, groups[i], KEY_LAUNCHES, NULL);
+		gint ready = g_key_file_get_integer (keyfile, groups[i], KEY_READY_COUNT, NULL);
+
+		if (launches <= 0)
+			continue;
+
+		applauncher_latency_log ("launch stats %s: n=%d click-to-exec avg=%.1f max=%.1f ms, "
+		                         "exec-to-ready n=%d avg=%.1f max=%.1f ms",
+		                         groups[i], launches,
+		                         g_key_file_get_double (keyfile, groups[i], KEY_EXEC_TOTAL, NULL) / launches,
+		                         g_key_file_get_double (keyfile, groups[i], KEY_EXEC_MAX, NULL),
+		                         ready,
+		                         ready > 0 ? g_key_file_get_double (keyfile, groups[i], KEY_READY_TOTAL, NULL) / ready : 0.0,
+		                         g_key_file_get_double (keyfile, groups[i], KEY_READY_MAX, NULL));
+	}
+
+	g_strfreev (groups);
+}
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Synthetic menus for the programs "make check" builds, so they never
+ * read the user's real one. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "applauncher-test-menu.h"
+
+
+static const gchar *categories[] = {
+	"Office", "Network", "Development", "Graphics", "AudioVideo", "Utility"
+};
+
+
+
+/* Writes @n_apps desktop files, bench-app-00000.desktop and on, under
+ * @dir/applications, and a menu file for them in @dir. The menu has a
+ * submenu per category if @with_categories, or lists every entry at
+ * the top level otherwise. */
+gboolean
+applauncher_test_write_menu (const gchar  *dir,
+                             guint         n_apps,
+                             gboolean      with_categories,
+                             gchar       **menu_file)
+{
+	guint i;
+	gchar *apps_dir;
+	GString *menu;
+	gboolean ret = TRUE;
+
+	apps_dir = g_build_filename (dir, "applications", NULL);
+	if (g_mkdir_with_parents (apps_dir, 0700) != 0) {
+		g_free (apps_dir);
+		return FALSE;
+	}
+
+	for (i = 0; i < n_apps && ret; i++) {
+		gchar *name = g_strdup_printf ("bench-app-%05u.desktop", i);
+		gchar *path = g_build_filename (apps_dir, name, NULL);
+		gchar *contents = g_strdup_printf ("[Desktop Entry]\n"
+		                                   "Type=Application\n"
+		                                   "Name=Bench Application %u\n"
+		                                   "Name[ko]=벤치 응용 프로그램 %u\n"
+		                                   "Comment=Synthetic entry number %u\n"
+		                                   "Exec=bench-app-%05u %%U\n"
+		                                   "Icon=application-x-executable\n"
+		                                   "Categories=%s;\n",
+		                                   i, i, i, i,
+		                                   categories[i % G_N_ELEMENTS (categories)]);
+
+		ret = g_file_set_contents (path, contents, -1, NULL);
+
+		g_free (contents);
+		g_free (path);
+		g_free (name);
+	}
+
+	menu = g_string_new ("<!DOCTYPE Menu PUBLIC \"-//freedesktop//DTD Menu 1.0//EN\"\n"
+	                     " \"http://www.freedesktop.org/standards/menu-spec/1.0/menu.dtd\">\n"
+	                     "<Menu>\n"
+	                     "  <Name>Applications</Name>\n");
+	g_string_append_printf (menu, "  <AppDir>%s</AppDir>\n", apps_dir);
+	if (with_categories) {
+		for (i = 0; i < G_N_ELEMENTS (categories); i++) {
+			g_string_append_printf (menu, "  <Menu>\n"
+			                              "    <Name>%s</Name>\n"
+			                              "    <Include><Category>%s</Category></Include>\n"
+			                              "  </Menu>\n",
+			                        categories[i], categories[i]);
+		}
+	} else {
+		g_string_append (menu, "  <Include><All/></Include>\n");
+	}
+	g_string_append (menu, "</Menu>\n");
+
+	*menu_file = g_build_filename (dir, "test-applications.menu", NULL);
+	if (ret)
+		ret = g_file_set_contents (*menu_file, menu->str, -1, NULL);
+
+	g_string_free (menu, TRUE);
+	g_free (apps_dir);
+
+	return ret;
+}
+
+void
+applauncher_test_remove_tree (const gchar *path)
+{
+	GDir *dir;
+	const gchar *name;
+
+	dir = g_dir_open (path, 0, NULL);
+	if (dir) {
+		while ((name = g_dir_read_name (dir)) != NULL) {
+			gchar *child = g_build_filename (path, name, NULL);
+			applauncher_test_remove_tree (child);
+			g_free (child);
+		}
+		g_dir_close (dir);
+	}
+
+	g_remove (path);
+}
@@ -0,0 +1,132 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Timing spans written in the Chrome trace event format ("JSON Array
+ * Format"), which chrome://tracing, Perfetto and speedscope can open.
+ * Tracing is switched on and off at runtime through the "trace-file"
+ * key; an empty value disables it. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "applauncher-trace.h"
+
+
+static GMutex     trace_lock;
+static FILE      *trace_fp = NULL;
+static gint       trace_on = FALSE;
+static GSettings *trace_settings = NULL;
+
+
+
+static void
+trace_file_changed_cb (GSettings   *settings,
+                       const gchar *key,
+                       gpointer     data)
+{
+	gchar *path;
+
+	path = g_settings_get_string (settings, "trace-file");
+
+	g_mutex_lock (&trace_lock);
+
+	if (trace_fp) {
+		fclose (trace_fp);
+		trace_fp = NULL;
+	}
+
+	if (path && path[0] != '\0') {
+		trace_fp = fopen (path, "a");
+		if (trace_fp) {
+			/* the array is left open on purpose, the viewers accept that */
+			if (ftell (trace_fp) == 0)
+				fputs ("[\n", trace_fp);
+		} else {
+			g_warning ("Could not open trace file '%s'", path);
+		}
+	}
+
+	g_atomic_int_set (&trace_on, trace_fp != NULL);
+
+	g_mutex_unlock (&trace_lock);
+
+	g_free (path);
+}
+
+void
+applauncher_trace_init (void)
+{
+	if (trace_settings)
+		return;
+
+	trace_settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	g_signal_connect (trace_settings, "changed::trace-file",
+	                  G_CALLBACK (trace_file_changed_cb), NULL);
+
+	trace_file_changed_cb (trace_settings, "trace-file", NULL);
+}
+
+gboolean
+applauncher_trace_enabled (void)
+{
+	return g_atomic_int_get (&trace_on);
+}
+
+/* Returns the start time of a span, or 0 if tracing is off, in which
+ * case the matching applauncher_trace_end() does nothing. */
+gint64
+applauncher_trace_begin (void)
+{
+	if (!applauncher_trace_enabled ())
+		return 0;
+
+	return g_get_monotonic_time ();
+}
+
+void
+applauncher_trace_end (gint64       begin,
+                       const gchar *name)
+{
+	gint64 end;
+
+	if (begin == 0)
+		return;
+
+	end = g_get_monotonic_time ();
+
+	g_mutex_lock (&trace_lock);
+
+	if (trace_fp) {
+		fprintf (trace_fp,
+		         "{\"name\":\"%s\",\"cat\":\"applauncher\",\"ph\":\"X\","
+		         "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ","
+		         "\"pid\":%d,\"tid\":%u},\n",
+		         name, begin, end - begin,
+		         (int) getpid (), g_direct_hash (g_thread_self ()));
+		fflush (trace_fp);
+	}
+
+	g_mutex_unlock (&trace_lock);
+}
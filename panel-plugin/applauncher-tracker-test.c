@@ -0,0 +1,232 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Checks which window applauncher_tracker_find() picks for a launch
+ * plan: maps windows with WM_CLASS and _NET_WM_PID on an X server, lists
+ * them in _NET_CLIENT_LIST as a window manager would, and asks for the
+ * StartupWMClass, executable and binary name cases, and for those that
+ * must only match on WM_CLASS. Runs on $DISPLAY, or on an Xvfb of its
+ * own if there is none. Built and run by "make check". */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <glib.h>
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#include "applauncher-tracker.h"
+
+
+#define TEST_SKIP     (77)    /* what automake takes for a skipped test */
+#define TEST_TIMEOUT  (5)     /* seconds for the tracker to see a change */
+
+
+static int n_failures = 0;
+
+
+
+/* Starts an Xvfb and points $DISPLAY to it, returns its pid or 0. */
+static GPid
+test_start_xvfb (void)
+{
+	gchar *argv[] = { NULL, "-displayfd", "1", "-nolisten", "tcp", "-screen", "0", "640x480x24", NULL };
+	gchar buffer[16], *display;
+	gint out = -1;
+	gssize len;
+	GPid pid;
+
+	argv[0] = g_find_program_in_path ("Xvfb");
+	if (!argv[0])
+		return 0;
+
+	if (!g_spawn_async_with_pipes (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDERR_TO_DEV_NULL,
+	                               NULL, NULL, &pid, NULL, &out, NULL, NULL)) {
+		g_free (argv[0]);
+		return 0;
+	}
+	g_free (argv[0]);
+
+	/* the display number, once it accepts connections */
+	len = read (out, buffer, sizeof (buffer) - 1);
+	close (out);
+	if (len <= 0) {
+		kill (pid, SIGTERM);
+		waitpid (pid, NULL, 0);
+		return 0;
+	}
+	buffer[len] = '\0';
+
+	display = g_strdup_printf (":%s", g_strstrip (buffer));
+	g_setenv ("DISPLAY", display, TRUE);
+	g_free (display);
+
+	return pid;
+}
+
+static int
+test_skip (GPid xvfb, const gchar *why)
+{
+	g_printerr ("applauncher-tracker-test: %s\n", why);
+
+	if (xvfb) {
+		kill (xvfb, SIGTERM);
+		waitpid (xvfb, NULL, 0);
+	}
+
+	return TEST_SKIP;
+}
+
+static Window
+test_map_window (Display *xdisplay, const gchar *res_name, const gchar *res_class, gulong pid)
+{
+	XClassHint hint;
+	Window xid;
+
+	xid = XCreateSimpleWindow (xdisplay, DefaultRootWindow (xdisplay), 0, 0, 10, 10, 0, 0, 0);
+
+	hint.res_name = (char *) res_name;
+	hint.res_class = (char *) res_class;
+	XSetClassHint (xdisplay, xid, &hint);
+
+	if (pid != 0)
+		XChangeProperty (xdisplay, xid, XInternAtom (xdisplay, "_NET_WM_PID", False),
+		                 XA_CARDINAL, 32, PropModeReplace, (guchar *) &pid, 1);
+
+	XMapWindow (xdisplay, xid);
+
+	return xid;
+}
+
+/* Gives the tracker the time to see the client list change. */
+static gulong
+test_wait_for (const ApplauncherLaunchPlan *plan, gulong expected)
+{
+	gint64 deadline = g_get_monotonic_time () + TEST_TIMEOUT * G_USEC_PER_SEC;
+	gulong found;
+
+	while ((found = applauncher_tracker_find (plan)) != expected && g_get_monotonic_time () < deadline) {
+		if (!g_main_context_iteration (NULL, FALSE))
+			g_usleep (1000);
+	}
+
+	return found;
+}
+
+static void
+test_expect (const gchar *what, const ApplauncherLaunchPlan *plan, gulong expected)
+{
+	gulong found = expected != 0 ? test_wait_for (plan, expected) : applauncher_tracker_find (plan);
+
+	if (found != expected) {
+		g_printerr ("applauncher-tracker-test: %s: window 0x%lx, expected 0x%lx\n", what, found, expected);
+		n_failures++;
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	ApplauncherLaunchPlan plan;
+	Display *xdisplay;
+	Window windows[5];
+	GPid xvfb = 0, child = 0;
+	gchar *child_argv[] = { NULL, "60", NULL };
+
+	if (!g_getenv ("DISPLAY")) {
+		xvfb = test_start_xvfb ();
+		if (!xvfb)
+			return test_skip (0, "no $DISPLAY and no Xvfb to start");
+	}
+
+	gdk_set_allowed_backends ("x11");
+	if (!gtk_init_check (&argc, &argv))
+		return test_skip (xvfb, "cannot open the display");
+
+	/* a process whose /proc/pid/exe is known */
+	child_argv[0] = g_find_program_in_path ("sleep");
+	if (!child_argv[0] || !g_spawn_async (NULL, child_argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+	                                      NULL, NULL, &child, NULL))
+		return test_skip (xvfb, "cannot run sleep");
+
+	applauncher_tracker_init (gdk_screen_get_default ());
+
+	xdisplay = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+	windows[0] = test_map_window (xdisplay, "testwm", "TestWMClass", 0);
+	windows[1] = test_map_window (xdisplay, "unrelated", "Unrelated", child);
+	windows[2] = test_map_window (xdisplay, "fakeapp", "Fakeapp", 0);
+	windows[3] = test_map_window (xdisplay, "python3", "Python3", 0);
+	windows[4] = test_map_window (xdisplay, "tool", "Tool", 0);
+
+	XChangeProperty (xdisplay, DefaultRootWindow (xdisplay),
+	                 XInternAtom (xdisplay, "_NET_CLIENT_LIST", False),
+	                 XA_WINDOW, 32, PropModeReplace, (guchar *) windows, G_N_ELEMENTS (windows));
+	XSync (xdisplay, False);
+
+	memset (&plan, 0, sizeof (plan));
+	plan.wm_class = (gchar *) "TestWMClass";
+	plan.binary = child_argv[0];
+	test_expect ("StartupWMClass", &plan, windows[0]);
+
+	/* the application said how to recognize it, nothing else counts */
+	plan.wm_class = (gchar *) "NoSuchClass";
+	test_expect ("StartupWMClass only", &plan, 0);
+
+	memset (&plan, 0, sizeof (plan));
+	plan.binary = child_argv[0];
+	test_expect ("executable", &plan, windows[1]);
+
+	/* xfce4-terminal and xfce4-terminal --drop-down */
+	plan.shares_binary = TRUE;
+	test_expect ("shared binary", &plan, 0);
+
+	memset (&plan, 0, sizeof (plan));
+	plan.binary = (gchar *) "/nonexistent/fakeapp";
+	test_expect ("binary name", &plan, windows[2]);
+
+	/* the WM_CLASS of some other Python application */
+	memset (&plan, 0, sizeof (plan));
+	plan.binary = (gchar *) "/nonexistent/python3";
+	test_expect ("interpreter", &plan, 0);
+
+	plan.desktop_id = (gchar *) "org.example.Tool.desktop";
+	test_expect ("interpreter by desktop id", &plan, windows[4]);
+
+	applauncher_tracker_shutdown ();
+
+	kill (child, SIGTERM);
+	waitpid (child, NULL, 0);
+	g_free (child_argv[0]);
+
+	if (xvfb) {
+		kill (xvfb, SIGTERM);
+		waitpid (xvfb, NULL, 0);
+	}
+
+	return n_failures > 0 ? 1 : 0;
+}
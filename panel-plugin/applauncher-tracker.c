@@ -0,0 +1,417 @@
+/*
+ *  Copyright (C) 2015-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+/* Keeps track of the top-level windows of running applications, so a
+ * click can raise an application that is already open instead of
+ * starting it again. The list follows _NET_CLIENT_LIST on the root
+ * window; only windows that appear are queried for WM_CLASS and
+ * _NET_WM_PID, once. */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <glib.h>
+#include <gdk/gdk.h>
+#include <gdk/gdkx.h>
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#include "applauncher-tracker.h"
+
+
+/* more windows than a desktop ever shows */
+#define MAX_CLIENTS           (4096)
+
+
+typedef struct
+{
+	Window  xid;
+	gchar  *res_name;
+	gchar  *res_class;
+	gchar  *exe;        /* resolved from _NET_WM_PID, or NULL */
+} TrackedWindow;
+
+
+static GdkScreen  *tracker_screen = NULL;
+static Atom        net_client_list;
+static Atom        net_wm_pid;
+static Atom        net_active_window;
+
+static GHashTable *windows = NULL;   /* Window → TrackedWindow */
+static GHashTable *by_class = NULL;  /* lowercase class or name → Window */
+static GHashTable *by_exe = NULL;    /* executable path → Window */
+static GHashTable *resolved = NULL;  /* plan binary → its real path, "" or NULL */
+
+/* Run other programs, so their path says nothing about the window. */
+static const gchar *launchers[] = {
+	"sh", "bash", "dash", "zsh", "env", "python", "perl", "ruby", "node", "nodejs",
+	"java", "mono", "gjs", "lua", "tclsh", "wish", "wine", "electron", "flatpak", "snap"
+};
+
+
+
+static void
+tracked_window_free (gpointer data)
+{
+	TrackedWindow *window = data;
+
+	g_free (window->res_name);
+	g_free (window->res_class);
+	g_free (window->exe);
+	g_slice_free (TrackedWindow, window);
+}
+
+static gulong *
+get_cardinals (Display *xdisplay, Window xwindow, Atom property, Atom type, gulong *n_items)
+{
+	Atom type_ret = None;
+	gint format_ret = 0;
+	gulong bytes_after_ret = 0;
+	guchar *prop_ret = NULL;
+
+	*n_items = 0;
+
+	if (XGetWindowProperty (xdisplay, xwindow, property, 0, MAX_CLIENTS, False, type,
+	                        &type_ret, &format_ret, n_items, &bytes_after_ret,
+	                        &prop_ret) != Success)
+		return NULL;
+
+	if (type_ret != type || format_ret != 32) {
+		if (prop_ret)
+			XFree (prop_ret);
+		*n_items = 0;
+		return NULL;
+	}
+
+	/* format 32 properties come back as longs */
+	return (gulong *) prop_ret;
+}
+
+static TrackedWindow *
+tracked_window_new (Display *xdisplay, Window xid)
+{
+	TrackedWindow *window;
+	XClassHint hint = { NULL, NULL };
+	gulong n_items;
+	gulong *pid;
+
+	window = g_slice_new0 (TrackedWindow);
+	window->xid = xid;
+
+	if (XGetClassHint (xdisplay, xid, &hint)) {
+		window->res_name = g_strdup (hint.res_name);
+		window->res_class = g_strdup (hint.res_class);
+		if (hint.res_name)
+			XFree (hint.res_name);
+		if (hint.res_class)
+			XFree (hint.res_class);
+	}
+
+	pid = get_cardinals (xdisplay, xid, net_wm_pid, XA_CARDINAL, &n_items);
+	if (pid) {
+		if (n_items > 0) {
+			gchar *proc = g_strdup_printf ("/proc/%lu/exe", pid[0]);
+			window->exe = g_file_read_link (proc, NULL);
+			g_free (proc);
+		}
+		XFree (pid);
+	}
+
+	return window;
+}
+
+static void
+index_add (GHashTable *index, const gchar *key, Window xid)
+{
+	if (key && key[0] != '\0')
+		g_hash_table_insert (index, g_utf8_strdown (key, -1), GUINT_TO_POINTER (xid));
+}
+
+static void
+update_client_list (void)
+{
+	Display *xdisplay;
+	Window xroot;
+	GHashTable *old;
+	gulong *clients;
+	gulong i, n_clients;
+
+	xdisplay = GDK_SCREEN_XDISPLAY (tracker_screen);
+	xroot = GDK_WINDOW_XID (gdk_screen_get_root_window (tracker_screen));
+
+	gdk_error_trap_push ();
+
+	clients = get_cardinals (xdisplay, xroot, net_client_list, XA_WINDOW, &n_clients);
+
+	old = windows;
+	windows = g_hash_table_new_full (NULL, NULL, NULL, tracked_window_free);
+
+	g_hash_table_remove_all (by_class);
+	g_hash_table_remove_all (by_exe);
+
+	/* in mapping order, so the newest window of a class wins */
+	for (i = 0; i < n_clients; i++) {
+		Window xid = clients[i];
+		TrackedWindow *window;
+
+		window = g_hash_table_lookup (old, GUINT_TO_POINTER (xid));
+		if (window)
+			g_hash_table_steal (old, GUINT_TO_POINTER (xid));
+		else
+			window = tracked_window_new (xdisplay, xid);
+
+		g_hash_table_insert (windows, GUINT_TO_POINTER (xid), window);
+
+		index_add (by_class, window->res_class, xid);
+		index_add (by_class, window->res_name, xid);
+		if (window->exe)
+			g_hash_table_insert (by_exe, g_strdup (window->exe), GUINT_TO_POINTER (xid));
+	}
+
+	gdk_error_trap_pop_ignored ();
+
+	if (clients)
+		XFree (clients);
+
+	/* what is left has been closed */
+	g_hash_table_destroy (old);
+}
+
+static GdkFilterReturn
+root_filter (GdkXEvent *gdk_xevent, GdkEvent *event, gpointer data)
+{
+	XEvent *xevent = gdk_xevent;
+
+	if (xevent->type == PropertyNotify && xevent->xproperty.atom == net_client_list)
+		update_client_list ();
+
+	return GDK_FILTER_CONTINUE;
+}
+
+static gboolean
+is_launcher (const gchar *path)
+{
+	gchar *name;
+	gsize len;
+	guint i;
+	gboolean ret = FALSE;
+
+	name = g_path_get_basename (path);
+
+	/* python3.11, java-17 */
+	len = strlen (name);
+	while (len > 0 && (g_ascii_isdigit (name[len - 1]) || name[len - 1] == '.' || name[len - 1] == '-'))
+		name[--len] = '\0';
+
+	for (i = 0; i < G_N_ELEMENTS (launchers); i++) {
+		if (g_strcmp0 (name, launchers[i]) == 0) {
+			ret = TRUE;
+			break;
+		}
+	}
+
+	g_free (name);
+
+	return ret;
+}
+
+/* Returns the real path of the binary of @plan, resolved once and then
+ * cached, as update_grid() asks for every visible cell on every redraw.
+ * Returns "" if it cannot be resolved, or %NULL for an interpreter or
+ * launcher, which must not be matched by executable or name. */
+static const gchar *
+plan_get_exe (const ApplauncherLaunchPlan *plan)
+{
+	gpointer exe;
+	gchar *real;
+
+	if (g_hash_table_lookup_extended (resolved, plan->binary, NULL, &exe))
+		return exe;
+
+	real = realpath (plan->binary, NULL);
+	if (is_launcher (plan->binary) || (real && is_launcher (real)))
+		exe = NULL;
+	else
+		exe = g_strdup (real ? real : "");
+	free (real);
+
+	g_hash_table_insert (resolved, g_strdup (plan->binary), exe);
+
+	return exe;
+}
+
+static gpointer
+find_by_class (const gchar *name)
+{
+	gpointer xid;
+	gchar *key;
+
+	key = g_utf8_strdown (name, -1);
+	xid = g_hash_table_lookup (by_class, key);
+	g_free (key);
+
+	return xid;
+}
+
+void
+applauncher_tracker_init (GdkScreen *screen)
+{
+	GdkWindow *root;
+	Display *xdisplay;
+
+	g_return_if_fail (GDK_IS_SCREEN (screen));
+
+	if (tracker_screen || !GDK_IS_X11_SCREEN (screen))
+		return;
+
+	tracker_screen = g_object_ref (screen);
+	root = gdk_screen_get_root_window (screen);
+	xdisplay = GDK_SCREEN_XDISPLAY (screen);
+
+	net_client_list = XInternAtom (xdisplay, "_NET_CLIENT_LIST", False);
+	net_wm_pid = XInternAtom (xdisplay, "_NET_WM_PID", False);
+	net_active_window = XInternAtom (xdisplay, "_NET_ACTIVE_WINDOW", False);
+
+	windows = g_hash_table_new_full (NULL, NULL, NULL, tracked_window_free);
+	by_class = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	by_exe = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	resolved = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	gdk_window_set_events (root, gdk_window_get_events (root) | GDK_PROPERTY_CHANGE_MASK);
+	gdk_window_add_filter (root, root_filter, NULL);
+
+	update_client_list ();
+}
+
+void
+applauncher_tracker_shutdown (void)
+{
+	if (!tracker_screen)
+		return;
+
+	gdk_window_remove_filter (gdk_screen_get_root_window (tracker_screen), root_filter, NULL);
+
+	g_clear_pointer (&windows, g_hash_table_destroy);
+	g_clear_pointer (&by_class, g_hash_table_destroy);
+	g_clear_pointer (&by_exe, g_hash_table_destroy);
+	g_clear_pointer (&resolved, g_hash_table_destroy);
+	g_clear_object (&tracker_screen);
+}
+
+/* Returns a window of the application @plan starts, or 0. Matches the
+ * StartupWMClass first, then the executable of the window's process,
+ * then the name of the binary against WM_CLASS. An application run by
+ * an interpreter or a launcher such as "flatpak run", or whose binary
+ * other entries run with other arguments, is only matched on WM_CLASS,
+ * against its desktop id. */
+gulong
+applauncher_tracker_find (const ApplauncherLaunchPlan *plan)
+{
+	const gchar *exe;
+	gpointer xid;
+
+	g_return_val_if_fail (plan != NULL, 0);
+
+	if (!tracker_screen)
+		return 0;
+
+	if (plan->wm_class) {
+		/* the application said how to recognize it, trust that only */
+		return GPOINTER_TO_UINT (find_by_class (plan->wm_class));
+	}
+
+	if (!plan->binary)
+		return 0;
+
+	exe = plan->shares_binary ? NULL : plan_get_exe (plan);
+	if (!exe) {
+		gchar *id, *dot;
+
+		if (!plan->desktop_id)
+			return 0;
+
+		/* org.gnome.Meld.desktop is Meld or org.gnome.Meld */
+		id = g_strdup (plan->desktop_id);
+		if (g_str_has_suffix (id, ".desktop"))
+			id[strlen (id) - strlen (".desktop")] = '\0';
+
+		xid = find_by_class (id);
+		dot = strrchr (id, '.');
+		if (!xid && dot && dot[1] != '\0')
+			xid = find_by_class (dot + 1);
+		g_free (id);
+
+		return GPOINTER_TO_UINT (xid);
+	}
+
+	if (exe[0] != '\0') {
+		xid = g_hash_table_lookup (by_exe, exe);
+		if (xid)
+			return GPOINTER_TO_UINT (xid);
+	}
+
+	gchar *basename = g_path_get_basename (plan->binary);
+	xid = find_by_class (basename);
+	g_free (basename);
+
+	return GPOINTER_TO_UINT (xid);
+}
+
+/* Asks the window manager to raise and focus @window, switching to its
+ * workspace and unminimizing it as needed. */
+void
+applauncher_tracker_activate (gulong  window,
+                              guint32 timestamp)
+{
+	XEvent xev;
+	Display *xdisplay;
+	Window xroot;
+
+	g_return_if_fail (window != 0);
+
+	if (!tracker_screen)
+		return;
+
+	xdisplay = GDK_SCREEN_XDISPLAY (tracker_screen);
+	xroot = GDK_WINDOW_XID (gdk_screen_get_root_window (tracker_screen));
+
+	memset (&xev, 0, sizeof (xev));
+	xev.xclient.type = ClientMessage;
+	xev.xclient.send_event = True;
+	xev.xclient.window = window;
+	xev.xclient.message_type = net_active_window;
+	xev.xclient.format = 32;
+	xev.xclient.data.l[0] = 2; /* source indication: pager */
+	xev.xclient.data.l[1] = timestamp;
+	xev.xclient.data.l[2] = 0;
+
+	gdk_error_trap_push ();
+	XSendEvent (xdisplay, xroot, False,
+	            SubstructureRedirectMask | SubstructureNotifyMask, &xev);
+	XFlush (xdisplay);
+	gdk_error_trap_pop_ignored ();
+}
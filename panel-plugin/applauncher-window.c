@@ -40,7 +40,14 @@
 #include <gmenu-tree.h>
 
 #include "xfce-spawn.h"
-#include "panel-glib.h"
+#include "applauncher-catalog.h"
+#include "applauncher-favorites.h"
+#include "applauncher-launch.h"
+#include "applauncher-latency.h"
+#include "applauncher-search.h"
+#include "applauncher-stats.h"
+#include "applauncher-tracker.h"
+#include "applauncher-trace.h"
 #include "applauncher-window.h"
 #include "applauncher-indicator.h"
 #include "applauncher-appitem.h"
@@ -48,22 +55,49 @@
 
 
 
-static GSList *get_all_applications_from_dir (GMenuTreeDirectory   *directory,
-                                              GSList               *list,
-                                              GSList               *blacklist);
+typedef struct
+{
+	ApplauncherCatalog *catalog;
+	GArray             *idxs; /* catalog indexes to launch */
+	GdkScreen          *screen;
+	guint32             timestamp;
+	gint64              request_time;
+
+	/* for a D-Bus activation */
+	GAppLaunchContext  *launch_context;
+	gchar              *startup_id;
+} LaunchData;
 
 struct _ApplauncherWindowPrivate
 {
 	GtkWidget  *grid;
 	GtkWidget  *ent_search;
 	GtkWidget  *box_bottom;
+	GtkWidget  *box_categories;
+	GtkWidget  *favorites_button;
 
 	ApplauncherIndicator *pages;
 
-	GList *grid_children;
+	GPtrArray *grid_items;  /* ApplauncherAppItem, by cell, see CELL_KEY */
+
+	ApplauncherCatalog *catalog;
+	GArray *text_matches;  /* catalog indexes matching filter_text */
+	GArray *filtered_apps; /* text_matches within category, shown */
+	gint    category;      /* or CATEGORY_ALL, CATEGORY_FAVORITES */
+	GArray *selection;     /* catalog indexes picked with Ctrl, in order */
+	GArray *favorites;     /* catalog indexes of the favorites, in order */
+
+	GSettings *settings;
+	gboolean   reorderable; /* items are drag sources, see grid_set_reorderable() */
+
+	ApplauncherSearch *search;
 
-	GSList *apps;
-	GSList *filtered_apps;
+	/* tooltips of the current page, reset on each update_grid() */
+	ApplauncherArena *grid_arena;
+
+	/* shown for every item, so that the theme reaches it */
+	GtkWidget *tooltip_window;
+	GtkWidget *tooltip_label;
 
 	int grid_x;
 	int grid_y;
@@ -72,817 +106,1406 @@ struct _ApplauncherWindowPrivate
 	int item_width;
 	int item_height;
 
-	gchar *filter_text;
+	GString *filter_text;
 	gchar **blacklist;
 
-	guint idle_entry_changed_id;
+	/* keystroke latency instrumentation, see applauncher-latency.h */
+	gint64         latency_start;
+	GdkFrameClock *latency_clock;
+	gulong         latency_paint_id;
+
+	/* page flips asked for since the last frame, see page_request() */
+	gint           pending_page;
+	gint           pending_cell;
+	guint          page_tick_id;
+	gdouble        scroll_delta;
 };
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (ApplauncherWindow, applauncher_window, GTK_TYPE_WINDOW)
 
 
-static gchar *
-desktop_working_directory_get (const gchar *id)
+/* cell of an item in the grid, plus one, set by populate_grid() */
+#define CELL_KEY "applauncher-cell"
+
+#define CATEGORY_ALL       (-1)
+#define CATEGORY_FAVORITES (-2)
+
+static gint
+item_get_cell (GtkWidget *item)
+{
+	return (gint) GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (item), CELL_KEY)) - 1;
+}
+
+/* Position in the results of the entry shown by @item, or -1. */
+static gint
+item_get_position (ApplauncherWindow *window, GtkWidget *item)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+	gint cell, pos;
+
+	cell = item_get_cell (item);
+	if (cell < 0)
+		return -1;
+
+	pos = cell + applauncher_indicator_get_active (priv->pages) * priv->grid_y * priv->grid_x;
+
+	return (pos < priv->filtered_apps->len) ? pos : -1;
+}
+
+/* Catalog index of the entry shown by @item, or -1. */
+static gint
+item_get_index (ApplauncherWindow *window, GtkWidget *item)
+{
+	gint pos = item_get_position (window, item);
+
+	return (pos < 0) ? -1 : (gint) g_array_index (window->priv->filtered_apps, guint, pos);
+}
+
+
+static gint
+selection_find (ApplauncherWindow *window, guint idx)
 {
-	gchar *wd = NULL;
+	ApplauncherWindowPrivate *priv = window->priv;
+	guint i;
 
-	GDesktopAppInfo *dt_info = g_desktop_app_info_new (id);
-	if (dt_info) {
-		wd = g_desktop_app_info_get_string (dt_info, G_KEY_FILE_DESKTOP_KEY_PATH);
+	for (i = 0; i < priv->selection->len; i++) {
+		if (g_array_index (priv->selection, guint, i) == idx)
+			return i;
 	}
 
-	return wd;
+	return -1;
 }
 
-static gboolean
-desktop_has_name (const gchar *id, const gchar *name)
+static void
+set_item_selected (ApplauncherAppItem *item, gboolean selected)
 {
-	const char *desktop;
-	gboolean ret = FALSE;
+	GtkStyleContext *context = gtk_widget_get_style_context (GTK_WIDGET (item));
+
+	if (selected)
+		gtk_style_context_add_class (context, "selected");
+	else
+		gtk_style_context_remove_class (context, "selected");
+}
+
+static void
+set_item_running (ApplauncherAppItem *item, gboolean running)
+{
+	GtkStyleContext *context = gtk_widget_get_style_context (GTK_WIDGET (item));
+
+	if (running)
+		gtk_style_context_add_class (context, "running");
+	else
+		gtk_style_context_remove_class (context, "running");
+}
+
+static int
+get_total_pages (ApplauncherWindow *window, GArray *list)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	return applauncher_catalog_count_pages (list->len, priv->grid_y * priv->grid_x);
+}
+
+static void
+update_pages (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	g_return_if_fail (priv->filtered_apps != NULL);
+
+	gint filtered_pages = get_total_pages (window, priv->filtered_apps);
+
+	// Update pages
+	if (filtered_pages > 1) {
+		gtk_widget_set_visible (GTK_WIDGET (priv->pages), TRUE);
+		GList *children = applauncher_indicator_get_children (priv->pages);
+		guint total_pages = g_list_length (children);
 
-	GDesktopAppInfo *dt_info = g_desktop_app_info_new (id);
-	if (dt_info) {
-		desktop = g_desktop_app_info_get_filename (dt_info);
+		int p;
+		for (p = 1; p <= total_pages; p++) {
+			GtkWidget *child = g_list_nth_data (children, p - 1);
+			if (child) {
+				gboolean visible = (p > filtered_pages) ? FALSE : TRUE;
+				gtk_widget_set_visible (child, visible);
+			}
+		}
 	} else {
-		desktop = NULL;
+		gtk_widget_set_visible (GTK_WIDGET (priv->pages), FALSE);
 	}
+}
 
-	if (desktop) {
-		GKeyFile *keyfile = g_key_file_new ();
-
-		if (g_key_file_load_from_file (keyfile, desktop,
-					G_KEY_FILE_KEEP_COMMENTS |
-					G_KEY_FILE_KEEP_TRANSLATIONS,
-					NULL)) {
-			gsize num_keys, i;
-			gchar **keys = g_key_file_get_keys (keyfile, "Desktop Entry", &num_keys, NULL);
-
-			for (i = 0; i < num_keys; i++) {
-				if (!g_str_has_prefix (keys[i], "Name"))
-					continue;
-
-				gchar *value = g_key_file_get_value (keyfile, "Desktop Entry", keys[i], NULL);
-				if (value) {
-					if (panel_g_utf8_strstrcase (value, name) != NULL) {
-						ret = TRUE;
-					}
+static void
+update_grid (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	gint r, c;
+	if (priv->filtered_apps->len == 0) {
+		for (r = 0; r < priv->grid_x; r++) {
+			for (c = 0; c < priv->grid_y; c++) {
+				gint pos = c + (r * priv->grid_y);
+				ApplauncherAppItem *item = g_ptr_array_index (priv->grid_items, pos);
+				if (item) {
+					gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
+					set_item_selected (item, FALSE);
+					set_item_running (item, FALSE);
+					applauncher_appitem_change_app (item, NULL, "", "");
 				}
-				g_free (value);
 			}
-			g_strfreev (keys);
 		}
-		g_key_file_free (keyfile);
+		update_pages (window);
+		return;
 	}
 
-	g_object_unref (dt_info);
+	GtkIconTheme *icon_theme = gtk_icon_theme_get_default ();
 
-	return ret;
-}
+	/* the items keep their own copy of the tooltip */
+	applauncher_arena_reset (priv->grid_arena);
 
-static gchar *
-find_desktop_by_id (GList *apps, const gchar *find_str)
-{
-	GList *l = NULL;
-	gchar *ret = NULL;
+	gint active = applauncher_indicator_get_active (priv->pages);
+	gint item_iter = active * priv->grid_y * priv->grid_x;
 
-	if (!find_str || g_str_equal (find_str, ""))
-		return NULL;
+	for (r = 0; r < priv->grid_x; r++) {
+		for (c = 0; c < priv->grid_y; c++) {
+			gint pos = c + (r * priv->grid_y); // position in table right now
+			ApplauncherAppItem *item = g_ptr_array_index (priv->grid_items, pos);
+			if (item_iter < priv->filtered_apps->len) {
+				guint idx = g_array_index (priv->filtered_apps, guint, item_iter);
+				GIcon *icon = applauncher_favorites_get_icon (applauncher_catalog_get_id (priv->catalog, idx),
+				                                              priv->icon_size);
+				if (!icon)
+					icon = applauncher_catalog_get_icon (priv->catalog, idx);
+				const gchar *name = applauncher_catalog_get_name (priv->catalog, idx);
+				const gchar *desc = applauncher_catalog_get_description (priv->catalog, idx);
 
-	for (l = apps; l; l = l->next) {
-		GAppInfo *appinfo = G_APP_INFO (l->data);
-		if (appinfo) {
-			const gchar *id = g_app_info_get_id (appinfo);
+				gtk_widget_set_sensitive (GTK_WIDGET (item), TRUE);
+				set_item_selected (item, selection_find (window, idx) >= 0);
 
-			if (g_str_equal (id, find_str)) {
-				ret = g_strdup (id);
-				break;
+				const ApplauncherLaunchPlan *plan = applauncher_catalog_get_launch_plan (priv->catalog, idx);
+				set_item_running (item, plan && applauncher_tracker_find (plan) != 0);
+				if (desc == NULL || g_strcmp0 (desc, "") == 0) {
+					applauncher_appitem_change_app (item, icon, name, name);
+				} else {
+					gchar *tooltip = applauncher_arena_strdup_printf (priv->grid_arena,
+					                                                  "%s:\n%s", name, desc);
+					applauncher_appitem_change_app (item, icon, name, tooltip);
+				}
+			} else { // fill with a blank one
+				gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
+				set_item_selected (item, FALSE);
+				set_item_running (item, FALSE);
+				applauncher_appitem_change_app (item, NULL, "", "");
 			}
 
-			if (desktop_has_name (id, find_str)) {
-				ret = g_strdup (id);
-				break;
-			}
+			item_iter++;
 		}
 	}
 
-	return ret;
+	// Update number of pages
+	update_pages (window);
 }
 
-static gboolean
-has_blacklist (GMenuTreeEntry *entry, GSList *blacklist)
+static void
+pages_activate_cb (ApplauncherIndicator *indicator, gpointer data)
 {
-	g_return_val_if_fail (entry && blacklist, FALSE);
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
 
-	GAppInfo *appinfo;
-	gboolean ret = FALSE;
+	update_grid (window);
+}
 
-	appinfo = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
-	if (appinfo) {
-		const char *id = g_app_info_get_id (appinfo);
-		if (id) {
-			GSList *l = NULL;
-			for (l = blacklist; l; l = l->next) {
-				gchar *_id = (gchar *)l->data;
-				if (g_str_equal (_id, ""))
-					continue;
-
-				if (g_str_equal (_id, id)) {
-					ret = TRUE;
-					break;
-				}
-			}
-		}
+static void
+latency_after_paint_cb (GdkFrameClock *clock,
+                        gpointer       data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	applauncher_latency_record (APPLAUNCHER_LATENCY_PRESENT,
+	                            g_get_monotonic_time () - priv->latency_start);
+
+	g_signal_handler_disconnect (priv->latency_clock, priv->latency_paint_id);
+	g_clear_object (&priv->latency_clock);
+	priv->latency_paint_id = 0;
+	priv->latency_start = 0;
+}
+
+static void
+latency_watch_next_frame (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	if (priv->latency_start == 0 || priv->latency_paint_id != 0)
+		return;
+
+	GdkFrameClock *clock = gtk_widget_get_frame_clock (GTK_WIDGET (window));
+	if (!clock) {
+		priv->latency_start = 0;
+		return;
 	}
 
-	return ret;
+	priv->latency_clock = g_object_ref (clock);
+
+	priv->latency_paint_id = g_signal_connect (priv->latency_clock, "after-paint",
+	                                           G_CALLBACK (latency_after_paint_cb), window);
 }
 
-static GSList *
-get_application_blacklist (void)
+static gboolean
+is_searching (ApplauncherWindow *window)
 {
-	guint i;
-	GSettings *settings;
-	gchar **blacklist = NULL;
-	GList *all_apps = NULL;
-	GSList *blacklist_apps = NULL, *l = NULL;
+	return window->priv->filter_text->len > 0;
+}
 
-	settings = g_settings_new ("apps.gooroom-applauncher-plugin");
-	blacklist = g_settings_get_strv (settings, "blacklist");
-	g_object_unref (settings);
+/* Narrows the text matches down to the current category, by merging
+ * two sorted lists; the menu is never looked at again. The favorites
+ * are shown in their own order, until something is typed. */
+static void
+filter_results (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+	const guint *members;
+	guint n_members;
 
-	all_apps = g_app_info_get_all ();
+	if (priv->category == CATEGORY_FAVORITES && !is_searching (window)) {
+		g_array_set_size (priv->filtered_apps, 0);
+		g_array_append_vals (priv->filtered_apps, priv->favorites->data, priv->favorites->len);
+		return;
+	}
 
-	for (i = 0; blacklist[i]; i++) {
-		if (!g_str_equal (blacklist[i], "")) {
-			// find desktop file
-			gchar *desktop = find_desktop_by_id (all_apps, blacklist[i]);
-			if (desktop) {
-				if (!g_slist_find_custom (blacklist_apps, desktop, (GCompareFunc) g_utf8_collate)) {
-					blacklist_apps = g_slist_append (blacklist_apps, desktop);
-				}
-			}
-		}
+	if (priv->category < 0) {
+		g_array_set_size (priv->filtered_apps, 0);
+		g_array_append_vals (priv->filtered_apps, priv->text_matches->data, priv->text_matches->len);
+		return;
 	}
 
-	g_strfreev (blacklist);
+	members = applauncher_catalog_get_category_members (priv->catalog, priv->category, &n_members);
+	applauncher_catalog_intersect ((const guint *) priv->text_matches->data, priv->text_matches->len,
+	                               members, n_members, priv->filtered_apps);
+}
+
+static void grid_set_reorderable (ApplauncherWindow *window, gboolean reorderable);
 
-	return blacklist_apps;
+static void
+show_results (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	filter_results (window);
+
+	grid_set_reorderable (window, priv->category == CATEGORY_FAVORITES && !is_searching (window));
+
+	/* page flips queued for the old results mean nothing now */
+	priv->pending_page = -1;
+	priv->pending_cell = -1;
+
+	/* back to the first page, even with a single one */
+	if (applauncher_indicator_get_children (priv->pages))
+		applauncher_indicator_set_active (priv->pages, 0);
+	else
+		update_grid (window);
 }
 
-/* Copied from gnome-panel-3.26.0/gnome-panel/menu.c:
- * get_applications_menu () */
-static gchar *
-get_applications_menu (void)
+static void
+search_done_cb (ApplauncherSearch *search,
+                const GArray      *matches,
+                gpointer           data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	if (priv->latency_start != 0)
+		applauncher_latency_record (APPLAUNCHER_LATENCY_SEARCH,
+		                            g_get_monotonic_time () - priv->latency_start);
+
+	/* sized for the whole catalog, so copying never grows it */
+	g_array_set_size (priv->text_matches, 0);
+	g_array_append_vals (priv->text_matches, matches->data, matches->len);
+
+	show_results (window);
+
+	if (priv->latency_start != 0) {
+		applauncher_latency_record (APPLAUNCHER_LATENCY_GRID,
+		                            g_get_monotonic_time () - priv->latency_start);
+		latency_watch_next_frame (window);
+	}
+}
+
+static void
+show_error_dialog (GtkWindow  *parent,
+                   gboolean    auto_destroy,
+                   const char *title,
+                   const char *primary_text,
+                   const char *secondary_text)
 {
-	const gchar *xdg_menu_prefx = g_getenv ("XDG_MENU_PREFIX");
+	GtkWidget *dialog;
 
-	if (xdg_menu_prefx == NULL )
-		return g_strdup ("gnome-applications.menu");
+	dialog = gtk_message_dialog_new (parent, 0,
+                                     GTK_MESSAGE_ERROR,
+                                     GTK_BUTTONS_CLOSE,
+                                     "%s", primary_text);
 
-	if (strlen (xdg_menu_prefx) == 0)
-		return g_strdup ("gnome-applications.menu");
+	gtk_window_set_title (GTK_WINDOW (dialog), title);
+
+	if (secondary_text != NULL)
+		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s", secondary_text);
 
-	return g_strdup_printf ("%sapplications.menu", xdg_menu_prefx);
+	gtk_widget_show_all (dialog);
+
+	if (auto_destroy) {
+		g_signal_connect_swapped (G_OBJECT (dialog), "response",
+				G_CALLBACK (gtk_widget_destroy),
+				G_OBJECT (dialog));
+	}
 }
 
 
-/* Copied from gnome-panel-3.26.0/gnome-panel/panel-run-dialog.c:
- * get_all_applications_from_alias () */
-static GSList *
-get_all_applications_from_alias (GMenuTreeAlias   *alias,
-                                 GSList           *list,
-                                 GSList           *blacklist)
+/* For a plan that could not be prepared, see applauncher_launch_plan_new(). */
+static void
+show_plan_error (GtkWindow *parent, const ApplauncherLaunchPlan *plan)
 {
-	switch (gmenu_tree_alias_get_aliased_item_type (alias))
-	{
-		case GMENU_TREE_ITEM_ENTRY: {
-			GMenuTreeEntry *entry = gmenu_tree_alias_get_aliased_entry (alias);
-			if (!has_blacklist (entry, blacklist))
-				/* pass on the reference */
-				list = g_slist_append (list, entry);
-			break;
-		}
+	gchar *primary = g_markup_printf_escaped (_("Could not run command '%s'"), plan->command);
 
-		case GMENU_TREE_ITEM_DIRECTORY: {
-			GMenuTreeDirectory *directory = gmenu_tree_alias_get_aliased_directory (alias);
-			list = get_all_applications_from_dir (directory, list, blacklist);
-			gmenu_tree_item_unref (directory);
-			break;
-		}
+	show_error_dialog (parent, TRUE, _("Application Launching Error"), primary, plan->error);
 
-		default:
-			break;
+	g_free (primary);
+}
+
+static gboolean
+launch_command (GdkScreen                   *screen,
+                const ApplauncherLaunchPlan *plan,
+                guint32                      timestamp,
+                gint64                       request_time)
+{
+	gboolean    result;
+	GError     *error = NULL;
+
+	if (!plan->argv)
+		return FALSE;
+
+	/* argv[0] is already resolved, no need to search $PATH again */
+	if (plan->desktop_id)
+		result = xfce_spawn_application_on_screen (screen, plan->working_directory,
+                                                   plan->argv, timestamp,
+                                                   plan->icon_name, plan->desktop_id,
+                                                   request_time, &error);
+	else
+		result = xfce_spawn_on_screen (screen, plan->working_directory,
+                                       plan->argv, NULL, 0,
+                                       TRUE, timestamp,
+                                       plan->icon_name, &error);
+
+	if (!result || error) {
+		gchar *primary = g_markup_printf_escaped (_("Could not run command '%s'"), plan->command);
+
+		/* the popup may be gone by now */
+		show_error_dialog (NULL, TRUE, _("Application Launching Error"), primary, error->message);
+
+		g_free (primary);
+
+		g_error_free (error);
 	}
 
-	return list;
+	return result;
 }
 
-/* Copied from gnome-panel-3.26.0/gnome-panel/panel-run-dialog.c:
- * get_all_applications_from_dir () */
-static GSList *
-get_all_applications_from_dir (GMenuTreeDirectory  *directory,
-                               GSList              *list,
-                               GSList              *blacklist)
+static LaunchData *
+launch_data_new (ApplauncherCatalog *catalog,
+                 GdkScreen          *screen,
+                 guint32             timestamp,
+                 gint64              request_time)
 {
-	GMenuTreeIter *iter;
-	GMenuTreeItemType next_type;
+	LaunchData *data = g_slice_new0 (LaunchData);
 
-	iter = gmenu_tree_directory_iter (directory);
+	data->catalog = applauncher_catalog_ref (catalog);
+	data->idxs = g_array_new (FALSE, FALSE, sizeof (guint));
+	data->screen = g_object_ref (screen);
+	data->timestamp = timestamp;
+	data->request_time = request_time;
 
-	while ((next_type = gmenu_tree_iter_next (iter)) != GMENU_TREE_ITEM_INVALID) {
-		switch (next_type) {
-			case GMENU_TREE_ITEM_ENTRY: {
-				GMenuTreeEntry *entry = gmenu_tree_iter_get_entry (iter);
-				if (!has_blacklist (entry, blacklist))
-					list = g_slist_append (list, entry);
-				break;
-			}
+	return data;
+}
 
-			case GMENU_TREE_ITEM_DIRECTORY: {
-				GMenuTreeDirectory *dir = gmenu_tree_iter_get_directory (iter);
-				list = get_all_applications_from_dir (dir, list, blacklist);
-				gmenu_tree_item_unref (dir);
-				break;
-			}
+static void
+launch_data_free (LaunchData *data)
+{
+	applauncher_catalog_unref (data->catalog);
+	g_array_unref (data->idxs);
+	g_object_unref (data->screen);
+	g_clear_object (&data->launch_context);
+	g_free (data->startup_id);
+	g_slice_free (LaunchData, data);
+}
 
-			case GMENU_TREE_ITEM_ALIAS: {
-				GMenuTreeAlias *alias = gmenu_tree_iter_get_alias (iter);
-				list = get_all_applications_from_alias (alias, list, blacklist);
-				gmenu_tree_item_unref (alias);
-				break;
-			}
+static void
+activate_done_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	LaunchData *data = user_data;
+	const ApplauncherLaunchPlan *plan;
+	GError *error = NULL;
 
-			default:
-			break;
+	plan = applauncher_catalog_get_launch_plan (data->catalog, g_array_index (data->idxs, guint, 0));
+
+	if (applauncher_launch_plan_activate_finish (result, &error)) {
+		if (plan->desktop_id)
+			applauncher_stats_record (plan->desktop_id,
+			                          g_get_monotonic_time () - data->request_time, -1);
+	} else {
+		/* the Exec line starts a sequence of its own */
+		if (data->startup_id)
+			g_app_launch_context_launch_failed (data->launch_context, data->startup_id);
+
+		/* not on the bus and no service file, run the Exec line instead */
+		if (!launch_command (data->screen, plan, data->timestamp, data->request_time) && !plan->argv) {
+			gchar *primary = g_markup_printf_escaped (_("Could not activate '%s'"), plan->dbus_name);
+
+			show_error_dialog (NULL, TRUE, _("Application Launching Error"), primary, error->message);
+
+			g_free (primary);
 		}
+		g_error_free (error);
 	}
 
-	gmenu_tree_iter_unref (iter);
+	launch_data_free (data);
+}
+
+/* Starts a startup-notification sequence, from the time of the click,
+ * for the application to complete once activated. */
+static void
+launch_data_activate (LaunchData *data, const ApplauncherLaunchPlan *plan)
+{
+	GDesktopAppInfo *app_info = NULL;
+	GdkAppLaunchContext *context;
+
+	if (plan->filename)
+		app_info = g_desktop_app_info_new_from_filename (plan->filename);
 
-	return list;
+	if (app_info) {
+		context = gdk_display_get_app_launch_context (gdk_screen_get_display (data->screen));
+		gdk_app_launch_context_set_screen (context, data->screen);
+		gdk_app_launch_context_set_timestamp (context, data->timestamp);
+
+		data->launch_context = G_APP_LAUNCH_CONTEXT (context);
+		data->startup_id = g_app_launch_context_get_startup_notify_id (data->launch_context,
+		                                                                G_APP_INFO (app_info), NULL);
+		g_object_unref (app_info);
+	}
+
+	applauncher_launch_plan_activate (plan, data->startup_id, NULL, activate_done_cb, data);
 }
 
 static gboolean
-has_application (GSList *list, GMenuTreeEntry *entry)
+launch_idle (gpointer user_data)
 {
-	const gchar *id;
-	if (entry) {
-		GAppInfo *app_info = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
-		if (app_info) {
-			id = g_app_info_get_id (app_info);
-		} else {
-			id = NULL;
+	LaunchData *data = user_data;
+	const ApplauncherLaunchPlan *plan;
+	GArray *requests;
+	GError *error = NULL;
+	guint i;
+
+	if (data->idxs->len == 1) {
+		plan = applauncher_catalog_get_launch_plan (data->catalog, g_array_index (data->idxs, guint, 0));
+
+		if (!plan || plan->error) {
+			if (plan)
+				show_plan_error (NULL, plan);
+			launch_data_free (data);
+			return FALSE;
 		}
-	} else {
-		id = NULL;
+
+		if (plan->dbus_name) {
+			launch_data_activate (data, plan);
+			return FALSE;
+		}
+
+		launch_command (data->screen, plan, data->timestamp, data->request_time);
+		launch_data_free (data);
+
+		return FALSE;
 	}
 
-	if (!id) return FALSE;
-
-	GSList *l = NULL;
-	for (l = list; l; l = l->next) {
-		GMenuTreeEntry *entry = (GMenuTreeEntry *)l->data;
-		if (entry) {
-			GAppInfo *app_info = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
-			if (app_info) {
-				const gchar *_id = g_app_info_get_id (app_info);
-				if (g_str_equal (_id, id))
-					return TRUE;
-			}
+	/* several at once, spawned in one batch */
+	requests = g_array_new (FALSE, TRUE, sizeof (XfceSpawnRequest));
+
+	for (i = 0; i < data->idxs->len; i++) {
+		guint idx = g_array_index (data->idxs, guint, i);
+
+		plan = applauncher_catalog_get_launch_plan (data->catalog, idx);
+		if (!plan)
+			continue;
+
+		/* the popup is gone, so each is reported on its own */
+		if (plan->error) {
+			show_plan_error (NULL, plan);
+			continue;
+		}
+
+		if (plan->dbus_name) {
+			LaunchData *single = launch_data_new (data->catalog, data->screen,
+			                                      data->timestamp, data->request_time);
+			g_array_append_val (single->idxs, idx);
+			launch_data_activate (single, plan);
+		} else if (plan->argv) {
+			XfceSpawnRequest request;
+
+			request.working_directory = plan->working_directory;
+			request.argv = plan->argv;
+			request.startup_icon_name = plan->icon_name;
+			request.application_id = plan->desktop_id;
+			g_array_append_val (requests, request);
 		}
 	}
 
+	if (!xfce_spawn_applications_on_screen (data->screen,
+                                            (const XfceSpawnRequest *) requests->data, requests->len,
+                                            data->timestamp, data->request_time, &error)) {
+		show_error_dialog (NULL, TRUE, _("Application Launching Error"),
+		                   _("Could not launch some of the applications"), error->message);
+		g_error_free (error);
+	}
+
+	g_array_free (requests, TRUE);
+	launch_data_free (data);
+
 	return FALSE;
 }
 
-/* Copied from gnome-panel-3.26.0/gnome-panel/panel-run-dialog.c:
- * get_all_applications () */
-static GSList *
-get_all_applications (GSList *blacklist)
+/* Closes the popup right away and launches once it is gone, so the
+ * click is answered within a frame whatever the spawn costs. */
+static void
+launch_plans (ApplauncherWindow *window, const guint *idxs, guint n_idxs)
 {
-	GMenuTree          *tree;
-	GMenuTreeDirectory *root;
-	GSList             *list = NULL;
-	gchar *applications_menu = NULL;
+	ApplauncherWindowPrivate *priv = window->priv;
+	LaunchData *data;
 
-	applications_menu = get_applications_menu ();
+	if (n_idxs == 0)
+		return;
 
-	tree = gmenu_tree_new (applications_menu, GMENU_TREE_FLAGS_SORT_DISPLAY_NAME);
-	g_free (applications_menu);
+	data = launch_data_new (priv->catalog,
+	                        gtk_window_get_screen (GTK_WINDOW (window)),
+	                        gtk_get_current_event_time (),
+	                        g_get_monotonic_time ());
+	g_array_append_vals (data->idxs, idxs, n_idxs);
 
-	if (!gmenu_tree_load_sync (tree, NULL)) {
-		g_object_unref (tree);
-		return NULL;
-	}
+	gtk_widget_hide (GTK_WIDGET (window));
+	gdk_display_flush (gdk_screen_get_display (data->screen));
 
-	root = gmenu_tree_get_root_directory (tree);
+	/* runs after the redraw that follows the unmap */
+	g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, launch_idle, data, NULL);
 
-	list = get_all_applications_from_dir (root, NULL, blacklist);
+	gtk_widget_destroy (GTK_WIDGET (window));
+}
 
-	gmenu_tree_item_unref (root);
-	g_object_unref (tree);
+/* Launches the Ctrl-selected entries, or the saved launch set if
+ * nothing is selected. */
+static void
+launch_selection (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+	GSettings *settings;
+	GArray *idxs;
+	gchar **launch_set;
+	guint i;
 
-	return list;
+	if (priv->selection->len > 0) {
+		launch_plans (window, (const guint *) priv->selection->data, priv->selection->len);
+		return;
+	}
+
+	settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	launch_set = g_settings_get_strv (settings, "launch-set");
+
+	idxs = g_array_new (FALSE, FALSE, sizeof (guint));
+	for (i = 0; launch_set[i] != NULL; i++) {
+		gint found = applauncher_catalog_find (priv->catalog, launch_set[i]);
+		if (found >= 0) {
+			guint idx = found;
+			g_array_append_val (idxs, idx);
+		}
+	}
+
+	launch_plans (window, (const guint *) idxs->data, idxs->len);
+
+	g_array_free (idxs, TRUE);
+	g_strfreev (launch_set);
+	g_object_unref (settings);
 }
 
-static int
-get_total_pages (ApplauncherWindow *window, GSList *list)
+static void
+save_launch_set (ApplauncherWindow *window)
 {
 	ApplauncherWindowPrivate *priv = window->priv;
+	GSettings *settings;
+	GPtrArray *ids;
+	guint i;
 
-	guint size = 0;
-	int num_pages = 0;
-
-	size = g_slist_length (list);
-	num_pages = (int)(size / (priv->grid_y * priv->grid_x));
+	ids = g_ptr_array_new ();
+	for (i = 0; i < priv->selection->len; i++) {
+		const ApplauncherLaunchPlan *plan;
 
-	if ((size %  (priv->grid_y * priv->grid_x)) > 0) {
-		num_pages += 1;
+		plan = applauncher_catalog_get_launch_plan (priv->catalog, g_array_index (priv->selection, guint, i));
+		if (plan && plan->desktop_id)
+			g_ptr_array_add (ids, plan->desktop_id);
 	}
+	g_ptr_array_add (ids, NULL);
 
-	return num_pages;
+	settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	g_settings_set_strv (settings, "launch-set", (const gchar * const *) ids->pdata);
+	g_object_unref (settings);
+
+	g_ptr_array_free (ids, TRUE);
 }
 
 static void
-update_pages (ApplauncherWindow *window)
+on_appitem_button_clicked_cb (GtkButton *button, gpointer data)
 {
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
 	ApplauncherWindowPrivate *priv = window->priv;
 
-	g_return_if_fail (priv->filtered_apps != NULL);
+	gint index = item_get_index (window, GTK_WIDGET (button));
 
-	guint size = 0;
-	gint filtered_pages = 0;
+	if (index < 0)
+		return;
+
+	guint idx = index;
+	const ApplauncherLaunchPlan *plan = applauncher_catalog_get_launch_plan (priv->catalog, idx);
+	if (!plan)
+		return;
+
+	/* Ctrl+click picks entries for launch_selection() */
+	GdkModifierType state = 0;
+	if (gtk_get_current_event_state (&state) && (state & GDK_CONTROL_MASK)) {
+		gint i = selection_find (window, idx);
 
-	size = g_slist_length (priv->filtered_apps);
-	filtered_pages = (int)(size / (priv->grid_y * priv->grid_x));
+		if (i >= 0)
+			g_array_remove_index (priv->selection, i);
+		else
+			g_array_append_val (priv->selection, idx);
 
-	if ((size %  (priv->grid_y * priv->grid_x)) > 0) {
-		filtered_pages += 1;
+		set_item_selected (APPLAUNCHER_APPITEM (button), i < 0);
+		return;
 	}
 
-	// Update pages
-	if (filtered_pages > 1) {
-		gtk_widget_set_visible (GTK_WIDGET (priv->pages), TRUE);
-		GList *children = applauncher_indicator_get_children (priv->pages);
-		guint total_pages = g_list_length (children);
+	if (plan->error) {
+		show_plan_error (GTK_WINDOW (window), plan);
+		return;
+	}
 
-		int p;
-		for (p = 1; p <= total_pages; p++) {
-			GtkWidget *child = g_list_nth_data (children, p - 1);
-			if (child) {
-				gboolean visible = (p > filtered_pages) ? FALSE : TRUE;
-				gtk_widget_set_visible (child, visible);
-			}
+	/* raise a running instance, Shift+click starts a new one */
+	if (!(state & GDK_SHIFT_MASK)) {
+		gulong running = applauncher_tracker_find (plan);
+
+		if (running != 0) {
+			applauncher_tracker_activate (running, gtk_get_current_event_time ());
+			gtk_widget_destroy (GTK_WIDGET (window));
+			return;
 		}
-	} else {
-		gtk_widget_set_visible (GTK_WIDGET (priv->pages), FALSE);
 	}
+
+	launch_plans (window, &idx, 1);
 }
 
+
+/* The search runs on its own thread, so the query is handed over right
+ * away: typing is echoed and painted while it runs, and a keystroke
+ * allocates nothing, see applauncher-search.c. */
 static void
-update_grid (ApplauncherWindow *window)
+on_search_entry_changed_cb (ApplauncherWindow *window)
 {
 	ApplauncherWindowPrivate *priv = window->priv;
+	const gchar *text = gtk_entry_get_text (GTK_ENTRY (priv->ent_search));
 
-	gint r, c;
-	if (priv->filtered_apps == NULL) {
-		for (r = 0; r < priv->grid_x; r++) {
-			for (c = 0; c < priv->grid_y; c++) {
-				gint pos = c + (r * priv->grid_y);
-				ApplauncherAppItem *item = g_list_nth_data (priv->grid_children, pos);
-				if (item) {
-					gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
-					applauncher_appitem_change_app (item, NULL, "", "");
-				}
-			}
-		}
+	/* measure from the oldest keystroke that has not been painted yet */
+	if (applauncher_latency_enabled () && priv->latency_start == 0)
+		priv->latency_start = g_get_monotonic_time ();
+
+	g_string_assign (priv->filter_text, text ? text : "");
+	applauncher_search_query (priv->search, priv->filter_text->str);
+}
+
+static void
+on_search_entry_activate_cb (GtkEditable *entry,
+                             gpointer     data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	guint size = priv->filtered_apps->len;
+	if (size == 0) return;
+
+	GtkWidget *focus = gtk_container_get_focus_child (GTK_CONTAINER (priv->grid));
+
+	if (focus) {
+		gtk_button_clicked (GTK_BUTTON (focus));
 		return;
 	}
 
-	GtkIconTheme *icon_theme = gtk_icon_theme_get_default ();
+	ApplauncherAppItem *item = g_ptr_array_index (priv->grid_items, 0);
 
-	gint active = applauncher_indicator_get_active (priv->pages);
-	gint item_iter = active * priv->grid_y * priv->grid_x;
+	gtk_widget_grab_focus (GTK_WIDGET (item));
+	if (size == 1) {
+		gtk_button_clicked (GTK_BUTTON (item));
+	}
+}
 
-	for (r = 0; r < priv->grid_x; r++) {
-		for (c = 0; c < priv->grid_y; c++) {
-			gint pos = c + (r * priv->grid_y); // position in table right now
-			ApplauncherAppItem *item = g_list_nth_data (priv->grid_children, pos);
-			if (item_iter < g_slist_length (priv->filtered_apps)) {
-				GMenuTreeEntry *entry = g_slist_nth_data (priv->filtered_apps, item_iter);
+static void
+on_search_entry_icon_release_cb (GtkEntry             *entry,
+                                 GtkEntryIconPosition  icon_pos,
+                                 GdkEvent             *event,
+                                 gpointer              user_data)
+{
+	if (icon_pos == GTK_ENTRY_ICON_SECONDARY) {
+		gtk_entry_set_text (GTK_ENTRY (entry), "");
+	}
+}
 
-				if (!entry) {
-					item_iter++;
-					gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
-					continue;
-				}
+/* The style sheet is given to each widget of the launcher rather than
+ * to the screen, so that the rest of the panel process never matches
+ * against it. */
+static GtkStyleProvider *
+get_style_provider (void)
+{
+	static GtkCssProvider *provider = NULL;
+	gint64 trace;
+
+	if (provider == NULL) {
+		trace = applauncher_trace_begin ();
+		provider = gtk_css_provider_new ();
+		gtk_css_provider_load_from_resource (provider, "/kr/gooroom/applauncher/theme/gooroom-applauncher.css");
+		applauncher_trace_end (trace, "css-load");
+	}
 
-				GAppInfo *app_info = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
+	return GTK_STYLE_PROVIDER (provider);
+}
 
-				if (!app_info) {
-					item_iter++;
-					gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
-					continue;
-				}
+static void
+apply_style (GtkWidget *widget, gpointer provider)
+{
+	gtk_style_context_add_provider (gtk_widget_get_style_context (widget),
+	                                GTK_STYLE_PROVIDER (provider),
+	                                GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
 
-				GIcon *icon = g_app_info_get_icon (app_info);
-				const gchar *name = g_app_info_get_name (app_info);
-				const gchar *desc = g_app_info_get_description (app_info);
+	if (GTK_IS_CONTAINER (widget))
+		gtk_container_forall (GTK_CONTAINER (widget), apply_style, provider);
+}
 
-				gtk_widget_set_sensitive (GTK_WIDGET (item), TRUE);
-				if (desc == NULL || g_strcmp0 (desc, "") == 0) {
-					applauncher_appitem_change_app (item, icon, name, name);
-				} else {
-					gchar *tooltip = g_strdup_printf ("%s:\n%s", name, desc);
-					applauncher_appitem_change_app (item, icon, name, tooltip);
-					g_free (tooltip);
-				}
-			} else { // fill with a blank one
-				gtk_widget_set_sensitive (GTK_WIDGET (item), FALSE);
-				applauncher_appitem_change_app (item, NULL, "", "");
-			}
+static void
+tooltip_window_update_visual (GtkWidget *widget, GdkScreen *previous_screen, gpointer data)
+{
+	GdkScreen *screen = gtk_widget_get_screen (widget);
+	GdkVisual *visual = gdk_screen_get_rgba_visual (screen);
 
-			item_iter++;
-		}
-	}
+	/* for the rounded corners */
+	if (visual == NULL || !gdk_screen_is_composited (screen))
+		visual = gdk_screen_get_system_visual (screen);
 
-	// Update number of pages
-	update_pages (window);
+	gtk_widget_set_visual (widget, visual);
 }
 
+/* GTK shares one tooltip window between every widget of the process,
+ * which a provider scoped to the launcher cannot reach, so the items
+ * bring their own. */
 static void
-pages_activate_cb (ApplauncherIndicator *indicator, gpointer data)
+tooltip_window_create (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	priv->tooltip_window = gtk_window_new (GTK_WINDOW_POPUP);
+	gtk_window_set_type_hint (GTK_WINDOW (priv->tooltip_window), GDK_WINDOW_TYPE_HINT_TOOLTIP);
+	gtk_widget_set_name (priv->tooltip_window, "applauncher-tooltip");
+	gtk_style_context_add_class (gtk_widget_get_style_context (priv->tooltip_window), "background");
+
+	tooltip_window_update_visual (priv->tooltip_window, NULL, NULL);
+	g_signal_connect (G_OBJECT (priv->tooltip_window), "screen-changed",
+	                  G_CALLBACK (tooltip_window_update_visual), NULL);
+
+	priv->tooltip_label = gtk_label_new (NULL);
+	gtk_label_set_line_wrap (GTK_LABEL (priv->tooltip_label), TRUE);
+	gtk_label_set_max_width_chars (GTK_LABEL (priv->tooltip_label), 70);
+	g_object_set (priv->tooltip_label, "margin", 6, NULL);
+	gtk_container_add (GTK_CONTAINER (priv->tooltip_window), priv->tooltip_label);
+	gtk_widget_show (priv->tooltip_label);
+}
+
+static gboolean
+on_appitem_query_tooltip_cb (GtkWidget  *widget,
+                             gint        x,
+                             gint        y,
+                             gboolean    keyboard_mode,
+                             GtkTooltip *tooltip,
+                             gpointer    data)
 {
 	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindowPrivate *priv = window->priv;
+	gchar *text;
+	gboolean ret = FALSE;
 
-	update_grid (window);
+	text = gtk_widget_get_tooltip_text (widget);
+	if (text && text[0] != '\0') {
+		gtk_label_set_text (GTK_LABEL (priv->tooltip_label), text);
+		ret = TRUE;
+	}
+	g_free (text);
+
+	return ret;
 }
 
+#define CATEGORY_KEY "applauncher-category"
+
+static void update_categories_visibility (ApplauncherWindow *window);
+
 static void
-search (ApplauncherWindow *window)
+on_category_toggled_cb (GtkToggleButton *button, gpointer data)
 {
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
 	ApplauncherWindowPrivate *priv = window->priv;
 
-	GSList *l = NULL, *apps = NULL;
-	for (l = priv->apps; l; l = l->next) {
-		GMenuTreeEntry *entry = (GMenuTreeEntry *)l->data;
+	if (!gtk_toggle_button_get_active (button))
+		return;
 
-		if (!entry) continue;
+	priv->category = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (button), CATEGORY_KEY)) - 1;
 
-		GAppInfo *app_info = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
+	update_categories_visibility (window);
+	show_results (window);
+}
 
-		if (!app_info) continue;
+static GtkWidget *
+category_button_new (ApplauncherWindow *window, GtkWidget *group, const gchar *label, gint category)
+{
+	GtkWidget *button;
 
-		const gchar *exec = g_app_info_get_executable (app_info);
-		if (exec && panel_g_utf8_strstrcase (exec, priv->filter_text) != NULL) {
-			if (!has_application (apps, entry))
-				apps = g_slist_append (apps, entry);
+	if (group)
+		button = gtk_radio_button_new_with_label_from_widget (GTK_RADIO_BUTTON (group), label);
+	else
+		button = gtk_radio_button_new_with_label (NULL, label);
 
-			continue;
-		}
+	gtk_toggle_button_set_mode (GTK_TOGGLE_BUTTON (button), FALSE);
+	gtk_button_set_relief (GTK_BUTTON (button), GTK_RELIEF_NONE);
+	gtk_widget_set_can_focus (button, FALSE);
+	gtk_widget_set_name (button, "category-button");
+	g_object_set_data (G_OBJECT (button), CATEGORY_KEY, GINT_TO_POINTER (category + 1));
 
-		const gchar *id = g_app_info_get_id (app_info);
-		if (desktop_has_name (id, priv->filter_text)) {
-			if (!has_application (apps, entry))
-				apps = g_slist_append (apps, entry);
+	g_signal_connect (G_OBJECT (button), "toggled", G_CALLBACK (on_category_toggled_cb), window);
 
-			continue;
-		}
-	}
+	gtk_box_pack_start (GTK_BOX (window->priv->box_categories), button, FALSE, FALSE, 0);
+	gtk_widget_show (button);
 
-	g_slist_free (priv->filtered_apps);
-	priv->filtered_apps = apps;
+	return button;
+}
 
-	int total_pages = get_total_pages (window, priv->filtered_apps);
-	if (total_pages > 1) {
-		applauncher_indicator_set_active (priv->pages, 0);
+static void
+update_categories_visibility (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	gtk_widget_set_visible (priv->favorites_button,
+	                        priv->favorites->len > 0 || priv->category == CATEGORY_FAVORITES);
+
+	gtk_widget_set_visible (priv->box_categories,
+	                        gtk_widget_get_visible (priv->favorites_button) ||
+	                        applauncher_catalog_get_n_categories (priv->catalog) >= 2);
+}
+
+/* One button per top-level menu directory, plus one for them all and
+ * one for the favorites, which the launcher opens on if there are
+ * any. */
+static void
+populate_categories (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
+	GtkWidget *all;
+	guint c, n_categories;
+
+	priv->favorites_button = category_button_new (window, NULL, _("Favorites"), CATEGORY_FAVORITES);
+	all = category_button_new (window, priv->favorites_button, _("All"), CATEGORY_ALL);
+
+	/* a single directory is no choice at all */
+	n_categories = applauncher_catalog_get_n_categories (priv->catalog);
+	if (n_categories >= 2) {
+		for (c = 0; c < n_categories; c++)
+			category_button_new (window, all,
+			                     applauncher_catalog_get_category_name (priv->catalog, c), c);
+	}
+
+	if (priv->favorites->len > 0) {
+		priv->category = CATEGORY_FAVORITES;
 	} else {
-		update_grid (window);
+		priv->category = CATEGORY_ALL;
+		g_signal_handlers_block_by_func (all, on_category_toggled_cb, window);
+		gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (all), TRUE);
+		g_signal_handlers_unblock_by_func (all, on_category_toggled_cb, window);
 	}
+
+	/* their visibility is ours, not that of the popup's show_all */
+	gtk_widget_set_no_show_all (priv->box_categories, TRUE);
+	gtk_widget_set_no_show_all (priv->favorites_button, TRUE);
+	update_categories_visibility (window);
 }
 
+/* Resolves the favorites against the catalog, skipping those that are
+ * not installed, or blacklisted, anymore. */
 static void
-show_error_dialog (GtkWindow  *parent,
-                   gboolean    auto_destroy,
-                   const char *title,
-                   const char *primary_text,
-                   const char *secondary_text)
+favorites_load (ApplauncherWindow *window)
 {
-	GtkWidget *dialog;
+	ApplauncherWindowPrivate *priv = window->priv;
+	gchar **ids;
+	guint i;
 
-	dialog = gtk_message_dialog_new (parent, 0,
-                                     GTK_MESSAGE_ERROR,
-                                     GTK_BUTTONS_CLOSE,
-                                     "%s", primary_text);
+	/* read here, the cache of applauncher-favorites.c may not have
+	 * seen the change yet */
+	ids = g_settings_get_strv (priv->settings, "favorites");
 
-	gtk_window_set_title (GTK_WINDOW (dialog), title);
+	g_array_set_size (priv->favorites, 0);
+	for (i = 0; ids[i] != NULL; i++) {
+		gint found = applauncher_catalog_find (priv->catalog, ids[i]);
+		if (found >= 0) {
+			guint idx = found;
+			g_array_append_val (priv->favorites, idx);
+		}
+	}
 
-	if (secondary_text != NULL)
-		gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s", secondary_text);
+	g_strfreev (ids);
+}
+
+/* The page stays where it is, a drag and drop is seen where it ended. */
+static void
+on_favorites_changed_cb (GSettings *settings, const gchar *key, gpointer data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindowPrivate *priv = window->priv;
+	gint total_pages;
+
+	favorites_load (window);
+	update_categories_visibility (window);
+
+	if (priv->category != CATEGORY_FAVORITES || is_searching (window))
+		return;
 
-	gtk_widget_show_all (dialog);
+	filter_results (window);
 
-	if (auto_destroy) {
-		g_signal_connect_swapped (G_OBJECT (dialog), "response",
-				G_CALLBACK (gtk_widget_destroy),
-				G_OBJECT (dialog));
-	}
+	total_pages = get_total_pages (window, priv->filtered_apps);
+	if (total_pages > 0 && applauncher_indicator_get_active (priv->pages) >= total_pages)
+		applauncher_indicator_set_active (priv->pages, total_pages - 1);
+	else
+		update_grid (window);
 }
 
+#define DESKTOP_ID_KEY "applauncher-desktop-id"
+
+static void
+on_favorite_activate_cb (GtkMenuItem *menuitem, gpointer data)
+{
+	const gchar *desktop_id = g_object_get_data (G_OBJECT (menuitem), DESKTOP_ID_KEY);
+
+	if (applauncher_favorites_contains (desktop_id))
+		applauncher_favorites_remove (desktop_id);
+	else
+		applauncher_favorites_add (desktop_id);
+}
 
 static gboolean
-command_is_executable (const char   *command,
-                       int          *argcp,
-                       char       ***argvp)
+menu_destroy_idle (gpointer data)
 {
-	gboolean   result;
-	char     **argv;
-	char      *path;
-	int        argc;
+	gtk_widget_destroy (GTK_WIDGET (data));
 
-	result = g_shell_parse_argv (command, &argc, &argv, NULL);
+	return FALSE;
+}
 
-	if (!result)
-		return FALSE;
+static void
+on_menu_deactivate_cb (GtkMenuShell *menu, gpointer data)
+{
+	/* the item is activated after the menu is deactivated */
+	g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, menu_destroy_idle, g_object_ref (menu), g_object_unref);
+}
 
-	path = g_find_program_in_path (argv[0]);
+static gboolean
+on_appitem_button_press_cb (GtkWidget      *widget,
+                            GdkEventButton *event,
+                            gpointer        data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindowPrivate *priv = window->priv;
+	GtkWidget *menu, *menuitem;
+	const gchar *desktop_id;
+	gint index;
 
-	if (!path) {
-		g_strfreev (argv);
+	if (event->type != GDK_BUTTON_PRESS || event->button != GDK_BUTTON_SECONDARY)
 		return FALSE;
-	}
 
-	/* If we pass an absolute path to g_find_program it just returns
-	 * that absolute path without checking if it is executable. Also
-	 * make sure its a regular file so we don't try to launch
-	 * directories or device nodes.
-	 */
-	if (!g_file_test (path, G_FILE_TEST_IS_EXECUTABLE) ||
-        !g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
-		g_free (path);
-		g_strfreev (argv);
+	index = item_get_index (window, widget);
+	if (index < 0)
 		return FALSE;
-	}
 
-	g_free (path);
+	desktop_id = applauncher_catalog_get_id (priv->catalog, index);
+	if (!desktop_id)
+		return FALSE;
 
-	if (argcp)
-		*argcp = argc;
-	if (argvp)
-		*argvp = argv;
+	menu = gtk_menu_new ();
+	menuitem = gtk_menu_item_new_with_label (applauncher_favorites_contains (desktop_id) ?
+	                                         _("Remove from Favorites") : _("Add to Favorites"));
+	g_object_set_data_full (G_OBJECT (menuitem), DESKTOP_ID_KEY, g_strdup (desktop_id), g_free);
+	g_signal_connect (G_OBJECT (menuitem), "activate", G_CALLBACK (on_favorite_activate_cb), NULL);
+	gtk_menu_shell_append (GTK_MENU_SHELL (menu), menuitem);
+	gtk_widget_show (menuitem);
+
+	gtk_menu_attach_to_widget (GTK_MENU (menu), widget, NULL);
+	g_signal_connect (G_OBJECT (menu), "deactivate", G_CALLBACK (on_menu_deactivate_cb), NULL);
+
+#if GTK_CHECK_VERSION (3, 22, 0)
+	gtk_menu_popup_at_pointer (GTK_MENU (menu), (GdkEvent *) event);
+#else
+	gtk_menu_popup (GTK_MENU (menu), NULL, NULL, NULL, NULL, event->button, event->time);
+#endif
 
 	return TRUE;
 }
 
-static gboolean
-launch_command (ApplauncherWindow *window,
-                const char        *command,
-                const char        *locale_command,
-                const char        *working_directory)
-{
-	GdkScreen  *screen;
-	gboolean    result;
-	GError     *error = NULL;
-	char      **argv;
-	int         argc;
-	GPid        pid;
+/* The favorites are reordered by dragging one onto another, only
+ * while they are shown in their own order. */
+static const GtkTargetEntry reorder_targets[] = {
+	{ (gchar *) "application/x-applauncher-favorite", GTK_TARGET_SAME_APP, 0 }
+};
 
+static void
+grid_set_reorderable (ApplauncherWindow *window, gboolean reorderable)
+{
 	ApplauncherWindowPrivate *priv = window->priv;
+	guint i;
 
-	const gchar *p;
-	GString *string = g_string_sized_new (100);
+	if (priv->reorderable == reorderable)
+		return;
 
-	for (p = locale_command; *p != '\0'; ++p) {
-		if (G_UNLIKELY (p[0] == '%' && p[1] != '\0')) {
-			switch (*++p) {
-				case '%':
-					g_string_append_c (string, '%');
-					break;
-					/* skip all the other %? values for now we don't have dnd anyways */
-			}
+	priv->reorderable = reorderable;
+
+	for (i = 0; i < priv->grid_items->len; i++) {
+		GtkWidget *item = g_ptr_array_index (priv->grid_items, i);
+
+		if (reorderable) {
+			gtk_drag_source_set (item, GDK_BUTTON1_MASK, reorder_targets,
+			                     G_N_ELEMENTS (reorder_targets), GDK_ACTION_MOVE);
+			gtk_drag_dest_set (item, GTK_DEST_DEFAULT_ALL, reorder_targets,
+			                   G_N_ELEMENTS (reorder_targets), GDK_ACTION_MOVE);
 		} else {
-			g_string_append_c (string, *p);
+			gtk_drag_source_unset (item);
+			gtk_drag_dest_unset (item);
 		}
 	}
+}
 
-	if (!command_is_executable (string->str, &argc, &argv))
-		return FALSE;
-
-	screen = gtk_window_get_screen (GTK_WINDOW (window));
-
-	result = xfce_spawn_on_screen (screen, working_directory,
-                                   argv, NULL, G_SPAWN_SEARCH_PATH,
-                                   TRUE, gtk_get_current_event_time (),
-                                   NULL, &error);
-
-	if (!result || error) {
-		gchar *primary = g_markup_printf_escaped (_("Could not run command '%s'"), command);
-
-		show_error_dialog (GTK_WINDOW (window), TRUE, _("Application Launching Error"), primary, error->message);
-
-		g_free (primary);
-
-		g_error_free (error);
-	}
+static void
+on_appitem_drag_begin_cb (GtkWidget      *widget,
+                          GdkDragContext *context,
+                          gpointer        data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	GIcon *icon;
+	gint index;
 
-	g_strfreev (argv);
+	index = item_get_index (window, widget);
+	if (index < 0)
+		return;
 
-	return result;
+	icon = applauncher_catalog_get_icon (window->priv->catalog, index);
+	if (icon)
+		gtk_drag_set_icon_gicon (context, icon, 0, 0);
 }
 
 static void
-on_appitem_button_clicked_cb (GtkButton *button, gpointer data)
+on_appitem_drag_data_get_cb (GtkWidget        *widget,
+                             GdkDragContext   *context,
+                             GtkSelectionData *selection,
+                             guint             info,
+                             guint             time,
+                             gpointer          data)
 {
 	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
-	ApplauncherWindowPrivate *priv = window->priv;
-
-	gint index = g_list_index (priv->grid_children, button);
+	const gchar *desktop_id;
+	gint index;
 
+	index = item_get_index (window, widget);
 	if (index < 0)
 		return;
 
-	gint active = applauncher_indicator_get_active (priv->pages);
-	gint pos = index + (active * priv->grid_y * priv->grid_x);
+	desktop_id = applauncher_catalog_get_id (window->priv->catalog, index);
+	if (desktop_id)
+		gtk_selection_data_set (selection, gtk_selection_data_get_target (selection), 8,
+		                        (const guchar *) desktop_id, strlen (desktop_id));
+}
+
+/* Puts the dragged favorite where the one it was dropped on is. */
+static void
+on_appitem_drag_data_received_cb (GtkWidget        *widget,
+                                  GdkDragContext   *context,
+                                  gint              x,
+                                  gint              y,
+                                  GtkSelectionData *selection,
+                                  guint             info,
+                                  guint             time,
+                                  gpointer          data)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	const gchar * const *ids = applauncher_favorites_get ();
+	const gchar *target_id;
+	gchar *desktop_id;
+	gint index;
+	guint i;
 
-	GMenuTreeEntry *entry = g_slist_nth_data (priv->filtered_apps, pos);
-	if (!entry)
+	index = item_get_index (window, widget);
+	if (index < 0 || gtk_selection_data_get_length (selection) <= 0)
 		return;
 
-	GAppInfo *app_info = G_APP_INFO (gmenu_tree_entry_get_app_info (entry));
-	const char *cmdline = g_app_info_get_commandline (app_info);
-	gchar *command = g_strdup (cmdline);
-	command = g_strchug (command);
+	target_id = applauncher_catalog_get_id (window->priv->catalog, index);
 
-	if (!command || !command[0]) {
-		g_free (command);
-		return;
+	desktop_id = g_strndup ((const gchar *) gtk_selection_data_get_data (selection),
+	                        gtk_selection_data_get_length (selection));
+
+	for (i = 0; ids[i] != NULL; i++) {
+		if (g_strcmp0 (ids[i], target_id) == 0) {
+			applauncher_favorites_move (desktop_id, i);
+			break;
+		}
 	}
 
-	GError *error = NULL;
-	gchar *disk = g_locale_from_utf8 (command, -1, NULL, NULL, &error);
+	g_free (desktop_id);
+}
 
-	if (!disk || error) {
-		gchar *primary = g_markup_printf_escaped (_("Could not run command '%s'"), command);
+static void
+populate_grid (ApplauncherWindow *window)
+{
+	ApplauncherWindowPrivate *priv = window->priv;
 
-		show_error_dialog (GTK_WINDOW (window), TRUE, _("Application Launching Error"), primary, error->message);
+	int r, c;
+	for (r = 0; r < priv->grid_x; r++) {
+		for (c = 0; c < priv->grid_y; c++) {
+			ApplauncherAppItem *item = applauncher_appitem_new (priv->icon_size);
+			gtk_widget_set_size_request (GTK_WIDGET (item), priv->item_width, priv->item_height);
+			gtk_grid_attach (GTK_GRID (priv->grid), GTK_WIDGET (item), c, r, 1, 1);
+			gtk_widget_show (GTK_WIDGET (item));
 
-		g_free (primary);
+			g_object_set_data (G_OBJECT (item), CELL_KEY, GUINT_TO_POINTER (priv->grid_items->len + 1));
+			g_ptr_array_add (priv->grid_items, item);
 
-		g_error_free (error);
+			g_signal_connect (G_OBJECT (item), "clicked", G_CALLBACK (on_appitem_button_clicked_cb), window);
 
-		return;
-	}
+			gtk_widget_set_tooltip_window (GTK_WIDGET (item), GTK_WINDOW (priv->tooltip_window));
+			g_signal_connect (G_OBJECT (item), "query-tooltip", G_CALLBACK (on_appitem_query_tooltip_cb), window);
 
-    /* if it's an absolute path or not a URI, it's possibly an executable,
-     * so try it before displaying it */
-	gchar *scheme = g_uri_parse_scheme (disk);
-    if (g_path_is_absolute (disk) || !scheme) {
-		const gchar *id = g_app_info_get_id (app_info);
-		gchar *wd = desktop_working_directory_get (id);
-		launch_command (window, command, disk, wd);
-		g_free (wd);
+			g_signal_connect (G_OBJECT (item), "button-press-event", G_CALLBACK (on_appitem_button_press_cb), window);
+			g_signal_connect (G_OBJECT (item), "drag-begin", G_CALLBACK (on_appitem_drag_begin_cb), window);
+			g_signal_connect (G_OBJECT (item), "drag-data-get", G_CALLBACK (on_appitem_drag_data_get_cb), window);
+			g_signal_connect (G_OBJECT (item), "drag-data-received", G_CALLBACK (on_appitem_drag_data_received_cb), window);
+		}
 	}
-
-	g_free (command);
-	g_free (disk);
 }
 
-
-static void
-search_entry_changed_idle_destroyed (gpointer data)
-{
-	APPLAUNCHER_WINDOW (data)->priv->idle_entry_changed_id = 0;
-}
+/* smooth scrolling that adds up to this much flips one page, the
+ * same as one notch of a wheel */
+#define SCROLL_PAGE_THRESHOLD (1.0)
 
 static gboolean
-search_entry_changed_idle (gpointer data)
+page_tick_cb (GtkWidget     *widget,
+              GdkFrameClock *clock,
+              gpointer       data)
 {
-	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (widget);
 	ApplauncherWindowPrivate *priv = window->priv;
 
-	const gchar *text = g_strdup (gtk_entry_get_text (GTK_ENTRY (priv->ent_search)));
+	priv->page_tick_id = 0;
 
-	g_free (priv->filter_text);
-	priv->filter_text = (text == NULL) ? g_strdup ("") : g_strdup (text);
+	if (priv->pending_page >= 0 &&
+	    priv->pending_page != applauncher_indicator_get_active (priv->pages))
+		applauncher_indicator_set_active (priv->pages, priv->pending_page);
 
-	search (window);
+	if (priv->pending_cell >= 0)
+		gtk_widget_grab_focus (g_ptr_array_index (priv->grid_items, priv->pending_cell));
 
-	return FALSE;
+	priv->pending_page = -1;
+	priv->pending_cell = -1;
+
+	return G_SOURCE_REMOVE;
 }
 
-static void
-on_search_entry_changed_cb (ApplauncherWindow *window)
+/* The page currently shown, or the one the next frame will show. */
+static gint
+page_get_target (ApplauncherWindow *window)
 {
 	ApplauncherWindowPrivate *priv = window->priv;
 
-	if (priv->idle_entry_changed_id != 0) {
-		g_source_remove (priv->idle_entry_changed_id);
-		priv->idle_entry_changed_id == 0;
-	}
+	if (priv->pending_page >= 0)
+		return priv->pending_page;
 
-	priv->idle_entry_changed_id =
-		gdk_threads_add_idle_full (G_PRIORITY_DEFAULT,
-                                   search_entry_changed_idle,
-                                   window,
-                                   search_entry_changed_idle_destroyed);
+	return applauncher_indicator_get_active (priv->pages);
 }
 
+/* Shows @page, and focuses @cell on it unless it is -1, on the next
+ * frame: however many requests arrive before it, the grid is updated
+ * once, for the last one. */
 static void
-on_search_entry_activate_cb (GtkEditable *entry,
-                             gpointer     data)
+page_request (ApplauncherWindow *window, gint page, gint cell)
 {
-	ApplauncherWindow *window = APPLAUNCHER_WINDOW (data);
 	ApplauncherWindowPrivate *priv = window->priv;
+	gint total_pages = get_total_pages (window, priv->filtered_apps);
 
-	guint size = g_slist_length (priv->filtered_apps);
-	if (size == 0) return;
+	if (total_pages == 0)
+		return;
 
-	GtkWidget *focus = gtk_container_get_focus_child (GTK_CONTAINER (priv->grid));
+	priv->pending_page = CLAMP (page, 0, total_pages - 1);
+	priv->pending_cell = cell;
 
-	if (focus) {
-		gtk_button_clicked (GTK_BUTTON (focus));
+	if (priv->page_tick_id != 0)
 		return;
-	}
 
-	ApplauncherAppItem *item = g_list_nth_data (priv->grid_children, 0);
-
-	gtk_widget_grab_focus (GTK_WIDGET (item));
-	if (size == 1) {
-		gtk_button_clicked (GTK_BUTTON (item));
+	if (!gtk_widget_get_realized (GTK_WIDGET (window))) {
+		page_tick_cb (GTK_WIDGET (window), NULL, NULL);
+		return;
 	}
+
+	priv->page_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (window), page_tick_cb, NULL, NULL);
 }
 
 static void
-on_search_entry_icon_release_cb (GtkEntry             *entry,
-                                 GtkEntryIconPosition  icon_pos,
-                                 GdkEvent             *event,
-                                 gpointer              user_data)
+applauncher_window_page_left (ApplauncherWindow *window)
 {
-	if (icon_pos == GTK_ENTRY_ICON_SECONDARY) {
-		gtk_entry_set_text (GTK_ENTRY (entry), "");
-	}
+	gint page = page_get_target (window);
+
+	if (page >= 1)
+		page_request (window, page - 1, -1);
 }
 
 static void
-populate_grid (ApplauncherWindow *window)
+applauncher_window_page_right (ApplauncherWindow *window)
+{
+	page_request (window, page_get_target (window) + 1, -1);
+}
+
+static gint
+applauncher_window_scroll (GtkWidget      *widget,
+                           GdkEventScroll *event)
 {
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (widget);
 	ApplauncherWindowPrivate *priv = window->priv;
+	gdouble dx, dy;
 
-	int r, c;
-	for (r = 0; r < priv->grid_x; r++) {
-		for (c = 0; c < priv->grid_y; c++) {
-			ApplauncherAppItem *item = applauncher_appitem_new (priv->icon_size);
-			gtk_widget_set_size_request (GTK_WIDGET (item), priv->item_width, priv->item_height);
-			gtk_grid_attach (GTK_GRID (priv->grid), GTK_WIDGET (item), c, r, 1, 1);
-			gtk_widget_show (GTK_WIDGET (item));
+	switch (event->direction)
+	{
+		case GDK_SCROLL_UP:
+			applauncher_window_page_left (window);
+		break;
+
+		case GDK_SCROLL_DOWN:
+			applauncher_window_page_right (window);
+		break;
 
-			priv->grid_children = g_list_append (priv->grid_children, item);
+		case GDK_SCROLL_SMOOTH:
+			if (!gdk_event_get_scroll_deltas ((GdkEvent *) event, &dx, &dy))
+				return FALSE;
 
-			g_signal_connect (G_OBJECT (item), "clicked", G_CALLBACK (on_appitem_button_clicked_cb), window);
-		}
+			/* either axis, touchpads are seldom exactly vertical */
+			priv->scroll_delta += (ABS (dy) >= ABS (dx)) ? dy : dx;
+
+			while (priv->scroll_delta >= SCROLL_PAGE_THRESHOLD) {
+				applauncher_window_page_right (window);
+				priv->scroll_delta -= SCROLL_PAGE_THRESHOLD;
+			}
+			while (priv->scroll_delta <= -SCROLL_PAGE_THRESHOLD) {
+				applauncher_window_page_left (window);
+				priv->scroll_delta += SCROLL_PAGE_THRESHOLD;
+			}
+
+			/* a new gesture starts from nothing */
+			if (gdk_event_is_scroll_stop_event ((GdkEvent *) event))
+				priv->scroll_delta = 0.0;
+		break;
+
+		default:
+			return FALSE;
 	}
+
+	return TRUE;
 }
 
-static void
-applauncher_window_page_left (ApplauncherWindow *window)
+/* Keyboard navigation works on the cursor, an index into the results
+ * rather than a widget: the page and the cell follow from it by plain
+ * arithmetic, and moving it changes the page and focuses the cell
+ * without walking any list, so holding a key down stays smooth. */
+static gint
+cursor_get (ApplauncherWindow *window)
 {
 	ApplauncherWindowPrivate *priv = window->priv;
+	GtkWidget *focus;
+	gint cell;
 
-	gint active = applauncher_indicator_get_active (priv->pages);
+	focus = gtk_container_get_focus_child (GTK_CONTAINER (priv->grid));
+	if (!focus || !gtk_widget_has_focus (focus))
+		return -1;
 
-	if (active >= 1) {
-		applauncher_indicator_set_active (priv->pages, active - 1);
-	}
+	cell = item_get_cell (focus);
+	if (cell < 0)
+		return -1;
+
+	/* a key repeat may come before the last move is shown */
+	if (priv->pending_cell >= 0)
+		cell = priv->pending_cell;
+
+	return page_get_target (window) * priv->grid_x * priv->grid_y + cell;
 }
 
 static void
-applauncher_window_page_right (ApplauncherWindow *window)
+cursor_set (ApplauncherWindow *window, gint cursor)
 {
 	ApplauncherWindowPrivate *priv = window->priv;
+	gint page_size = priv->grid_x * priv->grid_y;
 
-	gint total_pages = get_total_pages (window, priv->filtered_apps);
-	gint active = applauncher_indicator_get_active (priv->pages);
+	if (priv->filtered_apps->len == 0 || page_size == 0)
+		return;
 
-	if ((active + 1) < total_pages) {
-		applauncher_indicator_set_active (priv->pages, active + 1);
-	}
+	cursor = CLAMP (cursor, 0, (gint) priv->filtered_apps->len - 1);
+
+	page_request (window, cursor / page_size, cursor % page_size);
 }
 
-static gint
-applauncher_window_scroll (GtkWidget      *widget,
-                           GdkEventScroll *event)
+/* Returns TRUE if @keyval moved the cursor. */
+static gboolean
+cursor_navigate (ApplauncherWindow *window, guint keyval)
 {
-	ApplauncherWindow *window = APPLAUNCHER_WINDOW (widget);
-
-	if (event->direction == GDK_SCROLL_UP) {
-		applauncher_window_page_left (window);
-	} else if (event->direction == GDK_SCROLL_DOWN) {
-		applauncher_window_page_right (window);
-	} else {
+	ApplauncherWindowPrivate *priv = window->priv;
+	gint columns = priv->grid_y;
+	gint page_size = priv->grid_x * priv->grid_y;
+	gint cursor, target;
+
+	cursor = cursor_get (window);
+
+	/* from the search entry, only going down enters the grid */
+	if (cursor < 0) {
+		if (gtk_widget_has_focus (priv->ent_search) &&
+		    (keyval == GDK_KEY_Down || keyval == GDK_KEY_Page_Down)) {
+			cursor_set (window, 0);
+			return TRUE;
+		}
 		return FALSE;
 	}
 
+	switch (keyval)
+	{
+		case GDK_KEY_Left:      target = cursor - 1;          break;
+		case GDK_KEY_Right:     target = cursor + 1;          break;
+		case GDK_KEY_Up:        target = cursor - columns;    break;
+		case GDK_KEY_Down:      target = cursor + columns;    break;
+		case GDK_KEY_Page_Up:   target = cursor - page_size;  break;
+		case GDK_KEY_Page_Down: target = cursor + page_size;  break;
+		case GDK_KEY_Home:      target = 0;                   break;
+		case GDK_KEY_End:       target = G_MAXINT;            break;
+		default:
+			return FALSE;
+	}
+
+	/* up from the first row goes back to typing */
+	if (target < 0 && keyval == GDK_KEY_Up) {
+		gtk_widget_grab_focus (priv->ent_search);
+		return TRUE;
+	}
+
+	cursor_set (window, target);
+
 	return TRUE;
 }
 
@@ -891,7 +1514,6 @@ applauncher_window_key_press_event (GtkWidget   *widget,
                                     GdkEventKey *event)
 {
 	ApplauncherWindow *window = APPLAUNCHER_WINDOW (widget);
-	ApplauncherWindowPrivate *priv = window->priv;
 
 	switch (event->keyval)
 	{
@@ -899,29 +1521,32 @@ applauncher_window_key_press_event (GtkWidget   *widget,
 			gtk_widget_destroy (widget);
 		break;
 
-		case GDK_KEY_Left:
-		{
-			GtkWidget *focus = gtk_container_get_focus_child (GTK_CONTAINER (priv->grid));
-			if (focus) {
-				gint index = g_list_index (priv->grid_children, focus);
-				if ((index %  priv->grid_y) == 0) {
-					applauncher_window_page_left (window);
-				}
+		case GDK_KEY_Return:
+		case GDK_KEY_KP_Enter:
+			if (event->state & GDK_CONTROL_MASK) {
+				launch_selection (window);
+				return TRUE;
 			}
-			break;
-		}
+		break;
 
-		case GDK_KEY_Right:
-		{
-			GtkWidget *focus = gtk_container_get_focus_child (GTK_CONTAINER (priv->grid));
-			if (focus) {
-				gint index = g_list_index (priv->grid_children, focus);
-				if ((index %  priv->grid_y) == (priv->grid_y - 1)) {
-					applauncher_window_page_right (window);
-				}
+		case GDK_KEY_s:
+			if (event->state & GDK_CONTROL_MASK) {
+				save_launch_set (window);
+				return TRUE;
 			}
-			break;
-		}
+		break;
+
+		case GDK_KEY_Left:
+		case GDK_KEY_Right:
+		case GDK_KEY_Up:
+		case GDK_KEY_Down:
+		case GDK_KEY_Page_Up:
+		case GDK_KEY_Page_Down:
+		case GDK_KEY_Home:
+		case GDK_KEY_End:
+			if (cursor_navigate (window, event->keyval))
+				return TRUE;
+		break;
 
 		default:
 		break;
@@ -965,17 +1590,36 @@ static void
 applauncher_window_init (ApplauncherWindow *window)
 {
 	ApplauncherWindowPrivate *priv;
+	gint64 trace;
 
 	priv = window->priv = applauncher_window_get_instance_private (window);
 
+	trace = applauncher_trace_begin ();
 	gtk_widget_init_template (GTK_WIDGET (window));
+	applauncher_trace_end (trace, "template");
 
-	priv->apps = NULL;
-	priv->filtered_apps = NULL;
-	priv->grid_children = NULL;
+	priv->catalog = NULL;
+	priv->text_matches = g_array_new (FALSE, FALSE, sizeof (guint));
+	priv->filtered_apps = g_array_new (FALSE, FALSE, sizeof (guint));
+	priv->category = CATEGORY_ALL;
+	priv->selection = g_array_new (FALSE, FALSE, sizeof (guint));
+	priv->favorites = g_array_new (FALSE, FALSE, sizeof (guint));
+	priv->reorderable = FALSE;
+	priv->grid_items = g_ptr_array_new ();
 
-	priv->filter_text = NULL;
-	priv->idle_entry_changed_id = 0;
+	priv->search = NULL;
+	priv->grid_arena = applauncher_arena_new (4096);
+
+	priv->filter_text = g_string_sized_new (64);
+
+	priv->latency_start = 0;
+	priv->latency_clock = NULL;
+	priv->latency_paint_id = 0;
+
+	priv->pending_page = -1;
+	priv->pending_cell = -1;
+	priv->page_tick_id = 0;
+	priv->scroll_delta = 0.0;
 
 	gtk_window_set_skip_taskbar_hint (GTK_WINDOW (window), TRUE);
 	gtk_window_set_keep_above (GTK_WINDOW (window), TRUE);
@@ -991,18 +1635,7 @@ applauncher_window_init (ApplauncherWindow *window)
 	GdkRectangle area;
 	gdk_monitor_get_geometry (primary, &area);
 
-	// Set icon size
-	double suggested_size = pow (area.width * area.height, (double)(1.0/3.0)) / 1.6;
-
-	if (suggested_size < 27) {
-		priv->icon_size = 24;
-	} else if (suggested_size >= 27 && suggested_size < 40) {
-		priv->icon_size = 32;
-	} else if (suggested_size >= 40 && suggested_size < 56) {
-		priv->icon_size = 48;
-	} else if (suggested_size >= 56) {
-		priv->icon_size = 64;
-	}
+	priv->icon_size = applauncher_window_suggest_icon_size (screen);
 
 	if ((area.width / area.height) < 1.4) { // Monitor 5:4, 4:3
 		priv->grid_x = 4;
@@ -1021,40 +1654,55 @@ applauncher_window_init (ApplauncherWindow *window)
 	for (c = 0; c < priv->grid_y; c++)
 		gtk_grid_insert_column (GTK_GRID (priv->grid), c);
 
+	tooltip_window_create (window);
+
+	trace = applauncher_trace_begin ();
 	populate_grid (window);
+	applauncher_trace_end (trace, "populate-grid");
 
-	GSList *blacklist = get_application_blacklist ();
-	priv->apps = get_all_applications (blacklist);
-	g_slist_free_full (blacklist, (GDestroyNotify)g_free);
+	priv->catalog = applauncher_catalog_get_default ();
+	priv->search = applauncher_search_new (priv->catalog, search_done_cb, window);
 
-	GSList *l = NULL;
-	for (l = priv->apps; l; l = l->next) {
-		if (!has_application (priv->filtered_apps, l->data))
-			priv->filtered_apps = g_slist_append (priv->filtered_apps, l->data);
-	}
+	guint i;
+	for (i = 0; i < applauncher_catalog_get_n_entries (priv->catalog); i++)
+		g_array_append_val (priv->text_matches, i);
+
+	applauncher_favorites_init ();
+	priv->settings = g_settings_new ("apps.gooroom-applauncher-plugin");
+	g_signal_connect (priv->settings, "changed::favorites", G_CALLBACK (on_favorites_changed_cb), window);
+	favorites_load (window);
+
+	populate_categories (window);
+
+	filter_results (window);
+	grid_set_reorderable (window, priv->category == CATEGORY_FAVORITES);
 
 	priv->pages = applauncher_indicator_new ();
+	gtk_widget_set_no_show_all (GTK_WIDGET (priv->pages), TRUE);
 	gtk_box_set_spacing (GTK_BOX (priv->pages), 36);
 	gtk_box_pack_start (GTK_BOX (priv->box_bottom), GTK_WIDGET (priv->pages), FALSE, FALSE, 0);
 
-	int total_pages = get_total_pages (window, priv->filtered_apps);
-	if (total_pages > 1) {
-		gtk_widget_show (GTK_WIDGET (priv->pages));
+	trace = applauncher_trace_begin ();
 
-		g_signal_connect (G_OBJECT (priv->pages), "child-activate", G_CALLBACK (pages_activate_cb), window);
+	g_signal_connect (G_OBJECT (priv->pages), "child-activate", G_CALLBACK (pages_activate_cb), window);
 
-		int p;
-		for (p = 1; p <= total_pages; p++) {
-			char *string = g_strdup_printf ("%d", p);
-			applauncher_indicator_append (priv->pages, string);
-			g_free (string);
-		}
+	/* enough pages for All, the longest list there is; update_pages()
+	 * shows those the current one needs */
+	int total_pages = applauncher_catalog_count_pages (applauncher_catalog_get_n_entries (priv->catalog),
+	                                                   priv->grid_y * priv->grid_x);
+	int p;
+	for (p = 1; p <= total_pages; p++) {
+		char *string = g_strdup_printf ("%d", p);
+		applauncher_indicator_append (priv->pages, string);
+		g_free (string);
+	}
 
+	if (total_pages > 0)
 		applauncher_indicator_set_active (priv->pages, 0);
-	} else {
-		gtk_widget_hide (GTK_WIDGET (priv->pages));
+	else
 		update_grid (window);
-	}
+
+	applauncher_trace_end (trace, "update-grid");
 
 	g_signal_connect_swapped (G_OBJECT (priv->ent_search), "changed",
                G_CALLBACK (on_search_entry_changed_cb), window);
@@ -1065,23 +1713,68 @@ applauncher_window_init (ApplauncherWindow *window)
 	g_signal_connect (G_OBJECT (priv->ent_search), "activate",
                       G_CALLBACK (on_search_entry_activate_cb), window);
 
-	gtk_widget_add_events (GTK_WIDGET (window), GDK_SCROLL_MASK);
+	gtk_widget_add_events (GTK_WIDGET (window), GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
+
+	/* every widget exists by now, the page indicators included */
+	trace = applauncher_trace_begin ();
+	apply_style (GTK_WIDGET (window), get_style_provider ());
+	apply_style (priv->tooltip_window, get_style_provider ());
+	applauncher_trace_end (trace, "apply-style");
 }
 
 static void
-applauncher_window_finalize (GObject *object)
+applauncher_window_dispose (GObject *object)
 {
 	ApplauncherWindow *window = APPLAUNCHER_WINDOW (object);
 	ApplauncherWindowPrivate *priv = window->priv;
 
-	g_slist_free_full (priv->apps, (GDestroyNotify)gmenu_tree_item_unref);
-	g_slist_free (priv->filtered_apps);
+	g_clear_pointer (&priv->search, applauncher_search_free);
+
+	if (priv->latency_paint_id != 0) {
+		g_signal_handler_disconnect (priv->latency_clock, priv->latency_paint_id);
+		g_clear_object (&priv->latency_clock);
+		priv->latency_paint_id = 0;
+	}
+
+	if (priv->page_tick_id != 0) {
+		gtk_widget_remove_tick_callback (GTK_WIDGET (window), priv->page_tick_id);
+		priv->page_tick_id = 0;
+	}
+
+	if (priv->tooltip_window) {
+		gtk_widget_destroy (priv->tooltip_window);
+		priv->tooltip_window = NULL;
+	}
 
-	if (priv->idle_entry_changed_id != 0) {
-		g_source_remove (priv->idle_entry_changed_id);
-		priv->idle_entry_changed_id = 0;
+	if (priv->settings) {
+		g_signal_handlers_disconnect_by_func (priv->settings, on_favorites_changed_cb, window);
+		g_clear_object (&priv->settings);
 	}
 
+	(*G_OBJECT_CLASS (applauncher_window_parent_class)->dispose) (object);
+}
+
+static void
+applauncher_window_finalize (GObject *object)
+{
+	ApplauncherWindow *window = APPLAUNCHER_WINDOW (object);
+	ApplauncherWindowPrivate *priv = window->priv;
+
+	g_array_unref (priv->text_matches);
+	g_array_unref (priv->filtered_apps);
+	g_array_unref (priv->selection);
+	g_array_unref (priv->favorites);
+	g_ptr_array_free (priv->grid_items, TRUE);
+
+	applauncher_arena_free (priv->grid_arena);
+
+	if (priv->catalog)
+		applauncher_catalog_unref (priv->catalog);
+
+	g_string_free (priv->filter_text, TRUE);
+
+	applauncher_latency_report ();
+
 	(*G_OBJECT_CLASS (applauncher_window_parent_class)->finalize) (object);
 }
 
@@ -1091,6 +1784,7 @@ applauncher_window_class_init (ApplauncherWindowClass *klass)
 	GObjectClass   *object_class = G_OBJECT_CLASS (klass);
 	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+	object_class->dispose = applauncher_window_dispose;
 	object_class->finalize = applauncher_window_finalize;
 
 	widget_class->scroll_event = applauncher_window_scroll;
@@ -1103,6 +1797,7 @@ applauncher_window_class_init (ApplauncherWindowClass *klass)
 	gtk_widget_class_bind_template_child_private (GTK_WIDGET_CLASS (klass), ApplauncherWindow, ent_search);
 	gtk_widget_class_bind_template_child_private (GTK_WIDGET_CLASS (klass), ApplauncherWindow, grid);
 	gtk_widget_class_bind_template_child_private (GTK_WIDGET_CLASS (klass), ApplauncherWindow, box_bottom);
+	gtk_widget_class_bind_template_child_private (GTK_WIDGET_CLASS (klass), ApplauncherWindow, box_categories);
 }
 
 ApplauncherWindow *
@@ -1110,3 +1805,26 @@ applauncher_window_new (void)
 {
   return g_object_new (APPLAUNCHER_TYPE_WINDOW, NULL);
 }
+
+/* The icon size of the grid on the primary monitor of @screen, known
+ * ahead of any window so that icons can be rendered beforehand. */
+gint
+applauncher_window_suggest_icon_size (GdkScreen *screen)
+{
+	GdkDisplay *display = gdk_screen_get_display (screen);
+	GdkMonitor *primary = gdk_display_get_primary_monitor (display);
+
+	GdkRectangle area;
+	gdk_monitor_get_geometry (primary, &area);
+
+	double suggested_size = pow (area.width * area.height, (double)(1.0/3.0)) / 1.6;
+
+	if (suggested_size < 27)
+		return 24;
+	else if (suggested_size < 40)
+		return 32;
+	else if (suggested_size < 56)
+		return 48;
+
+	return 64;
+}
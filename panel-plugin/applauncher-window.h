@@ -52,6 +52,8 @@ GType      applauncher_window_get_type     (void) G_GNUC_CONST;
 
 ApplauncherWindow *applauncher_window_new  (void);
 
+gint       applauncher_window_suggest_icon_size (GdkScreen *screen);
+
 G_END_DECLS
 
 #endif /* !__APPLAUNCHER_WINDOW_H__ */
@@ -42,6 +42,8 @@
 #include <glib/gstdio.h>
 #include <glib/gi18n.h>
 
+#include "applauncher-spawn.h"
+#include "applauncher-stats.h"
 #include "xfce-spawn.h"
 
 #ifdef HAVE__NSGETENVIRON
@@ -67,8 +69,68 @@ typedef struct
   guint              watch_id;
   GPid               pid;
   GClosure          *closure;
+
+  /* launch telemetry, application_id is cleared once recorded */
+  struct _XfceSpawnScreen *spawn_screen;
+  gchar             *application_id;
+  gint64             request_time;
+  gint64             exec_time;
 } XfceSpawnData;
 
+typedef struct
+{
+  /* shallow copy of the environ the template was built from */
+  gchar            **environ_copy;
+  guint              n_environ;
+
+  /* child environment, the last slot is left free for $DESKTOP_STARTUP_ID */
+  gchar            **envp;
+  guint              startup_id_slot;
+} XfceSpawnEnv;
+
+
+
+typedef struct _XfceSpawnScreen
+{
+  GdkScreen         *screen;
+
+  /* long-lived startup notification display */
+  SnDisplay         *sn_display;
+
+  /* watches for the end of our startup sequences */
+  SnMonitorContext  *sn_monitor;
+  GHashTable        *pending;
+
+  /* atoms of the workspace properties on the root window */
+  Atom               net_current_desktop;
+  Atom               win_workspace;
+
+  /* active workspace, kept up to date by PropertyNotify */
+  gint               workspace;
+} XfceSpawnScreen;
+
+
+
+static GQuark xfce_spawn_env_quark = 0;
+static GQuark xfce_spawn_screen_quark = 0;
+
+
+
+static void
+xfce_spawn_record_launch (XfceSpawnData *spawn_data,
+                          gint64         ready_usec)
+{
+  if (spawn_data->application_id == NULL)
+    return;
+
+  applauncher_stats_record (spawn_data->application_id,
+                            spawn_data->exec_time - spawn_data->request_time,
+                            ready_usec);
+
+  g_free (spawn_data->application_id);
+  spawn_data->application_id = NULL;
+}
+
 
 
 static gboolean
@@ -100,8 +162,14 @@ xfce_spawn_startup_timeout_destroy (gpointer user_data)
 
   spawn_data->timeout_id = 0;
 
+  /* timed out or the child exited before it was ready */
+  xfce_spawn_record_launch (spawn_data, -1);
+
   if (G_LIKELY (spawn_data->sn_launcher != NULL))
    {
+     g_hash_table_remove (spawn_data->spawn_screen->pending,
+                          sn_launcher_context_get_startup_id (spawn_data->sn_launcher));
+
      /* abort the startup notification */
      sn_launcher_context_complete (spawn_data->sn_launcher);
      sn_launcher_context_unref (spawn_data->sn_launcher);
@@ -168,39 +236,126 @@ xfce_spawn_startup_watch_destroy (gpointer user_data)
       g_closure_unref (spawn_data->closure);
     }
 
+  g_free (spawn_data->application_id);
+
   g_slice_free (XfceSpawnData, spawn_data);
 }
 
+static gchar **
+xfce_spawn_env_build (gchar     **envp,
+                      GdkScreen  *screen,
+                      guint      *startup_id_slot)
+{
+  gchar **cenvp;
+  gchar  *display_name;
+  guint   n;
+  guint   n_cenvp;
+
+  /* copy the environment (stripping $DESKTOP_STARTUP_ID and $DISPLAY) */
+  for (n = 0; envp[n] != NULL; ++n);
+  cenvp = g_new0 (gchar *, n + 3);
+  for (n_cenvp = n = 0; envp[n] != NULL; ++n)
+    {
+      if (strncmp (envp[n], "DESKTOP_STARTUP_ID", 18) != 0
+          && strncmp (envp[n], "DISPLAY", 7) != 0)
+        cenvp[n_cenvp++] = g_strdup (envp[n]);
+    }
+
+  /* add the real display name for the screen */
+  display_name = gdk_screen_make_display_name (screen);
+  cenvp[n_cenvp++] = g_strconcat ("DISPLAY=", display_name, NULL);
+  g_free (display_name);
+
+  *startup_id_slot = n_cenvp;
+
+  return cenvp;
+}
+
+
+
+static void
+xfce_spawn_env_free (gpointer user_data)
+{
+  XfceSpawnEnv *env = user_data;
+
+  /* the startup id slot is always empty outside a spawn */
+  g_strfreev (env->envp);
+  g_free (env->environ_copy);
+  g_slice_free (XfceSpawnEnv, env);
+}
+
+
+
+static gboolean
+xfce_spawn_env_is_current (XfceSpawnEnv *env)
+{
+  guint n;
+
+  /* setenv() and putenv() always store a new pointer in environ,
+   * so comparing the pointers is enough to notice a change */
+  for (n = 0; environ[n] != NULL; ++n)
+    if (n >= env->n_environ || environ[n] != env->environ_copy[n])
+      return FALSE;
+
+  return n == env->n_environ;
+}
+
+
+
+static XfceSpawnEnv *
+xfce_spawn_env_get (GdkScreen *screen)
+{
+  XfceSpawnEnv *env;
+  guint         n;
+
+  if (G_UNLIKELY (xfce_spawn_env_quark == 0))
+    xfce_spawn_env_quark = g_quark_from_static_string ("xfce-spawn-env");
+
+  env = g_object_get_qdata (G_OBJECT (screen), xfce_spawn_env_quark);
+  if (G_LIKELY (env != NULL && xfce_spawn_env_is_current (env)))
+    return env;
+
+  /* (re)build the template for this screen */
+  for (n = 0; environ[n] != NULL; ++n);
+
+  env = g_slice_new0 (XfceSpawnEnv);
+  env->n_environ = n;
+  env->environ_copy = g_memdup (environ, sizeof (gchar *) * (n + 1));
+  env->envp = xfce_spawn_env_build ((gchar **) environ, screen, &env->startup_id_slot);
+
+  /* drops the previous template, if any */
+  g_object_set_qdata_full (G_OBJECT (screen), xfce_spawn_env_quark,
+                           env, xfce_spawn_env_free);
+
+  return env;
+}
+
+
+
 static gint
-xfce_spawn_get_active_workspace_number (GdkScreen *screen)
+xfce_spawn_read_workspace_number (XfceSpawnScreen *spawn_screen)
 {
-  GdkWindow *root;
+  Display   *xdisplay;
+  Window     xroot;
   gulong     bytes_after_ret = 0;
   gulong     nitems_ret = 0;
   guint     *prop_ret = NULL;
-  Atom       _NET_CURRENT_DESKTOP;
-  Atom       _WIN_WORKSPACE;
   Atom       type_ret = None;
   gint       format_ret;
   gint       ws_num = 0;
 
   gdk_error_trap_push ();
 
-  root = gdk_screen_get_root_window (screen);
-
-  /* determine the X atom values */
-  _NET_CURRENT_DESKTOP = XInternAtom (GDK_WINDOW_XDISPLAY (root), "_NET_CURRENT_DESKTOP", False);
-  _WIN_WORKSPACE = XInternAtom (GDK_WINDOW_XDISPLAY (root), "_WIN_WORKSPACE", False);
+  xdisplay = GDK_SCREEN_XDISPLAY (spawn_screen->screen);
+  xroot = GDK_WINDOW_XID (gdk_screen_get_root_window (spawn_screen->screen));
 
-  if (XGetWindowProperty (GDK_WINDOW_XDISPLAY (root),
-                          gdk_x11_get_default_root_xwindow(),
-                          _NET_CURRENT_DESKTOP, 0, 32, False, XA_CARDINAL,
+  if (XGetWindowProperty (xdisplay, xroot,
+                          spawn_screen->net_current_desktop, 0, 32, False, XA_CARDINAL,
                           &type_ret, &format_ret, &nitems_ret, &bytes_after_ret,
                           (gpointer) &prop_ret) != Success)
     {
-      if (XGetWindowProperty (GDK_WINDOW_XDISPLAY (root),
-                              gdk_x11_get_default_root_xwindow(),
-                              _WIN_WORKSPACE, 0, 32, False, XA_CARDINAL,
+      if (XGetWindowProperty (xdisplay, xroot,
+                              spawn_screen->win_workspace, 0, 32, False, XA_CARDINAL,
                               &type_ret, &format_ret, &nitems_ret, &bytes_after_ret,
                               (gpointer) &prop_ret) != Success)
         {
@@ -224,6 +379,128 @@ xfce_spawn_get_active_workspace_number (GdkScreen *screen)
   return ws_num;
 }
 
+
+
+static GdkFilterReturn
+xfce_spawn_root_filter (GdkXEvent *gdk_xevent,
+                        GdkEvent  *event,
+                        gpointer   user_data)
+{
+  XfceSpawnScreen *spawn_screen = user_data;
+  XEvent          *xevent = gdk_xevent;
+
+  /* startup notification messages are sent to the root window */
+  if (G_LIKELY (spawn_screen->sn_display != NULL))
+    sn_display_process_event (spawn_screen->sn_display, xevent);
+
+  /* refresh the workspace when the window manager switches it, so
+   * launching never has to ask the X server */
+  if (xevent->type == PropertyNotify
+      && (xevent->xproperty.atom == spawn_screen->net_current_desktop
+          || xevent->xproperty.atom == spawn_screen->win_workspace))
+    spawn_screen->workspace = xfce_spawn_read_workspace_number (spawn_screen);
+
+  return GDK_FILTER_CONTINUE;
+}
+
+
+
+static void
+xfce_spawn_monitor_event (SnMonitorEvent *event,
+                          void           *user_data)
+{
+  XfceSpawnScreen   *spawn_screen = user_data;
+  XfceSpawnData     *spawn_data;
+  SnStartupSequence *sequence;
+
+  if (sn_monitor_event_get_type (event) != SN_MONITOR_EVENT_COMPLETED)
+    return;
+
+  sequence = sn_monitor_event_get_startup_sequence (event);
+  spawn_data = g_hash_table_lookup (spawn_screen->pending,
+                                    sn_startup_sequence_get_id (sequence));
+  if (spawn_data == NULL)
+    return;
+
+  xfce_spawn_record_launch (spawn_data, g_get_monotonic_time () - spawn_data->exec_time);
+
+  /* the sequence is over, no need to wait for the timeout */
+  if (spawn_data->timeout_id != 0)
+    g_source_remove (spawn_data->timeout_id);
+}
+
+
+
+static void
+xfce_spawn_screen_free (gpointer user_data)
+{
+  XfceSpawnScreen *spawn_screen = user_data;
+
+  gdk_window_remove_filter (gdk_screen_get_root_window (spawn_screen->screen),
+                            xfce_spawn_root_filter, spawn_screen);
+
+  if (G_LIKELY (spawn_screen->sn_monitor != NULL))
+    sn_monitor_context_unref (spawn_screen->sn_monitor);
+
+  g_hash_table_destroy (spawn_screen->pending);
+
+  if (G_LIKELY (spawn_screen->sn_display != NULL))
+    sn_display_unref (spawn_screen->sn_display);
+
+  g_slice_free (XfceSpawnScreen, spawn_screen);
+}
+
+
+
+static XfceSpawnScreen *
+xfce_spawn_screen_get (GdkScreen *screen)
+{
+  XfceSpawnScreen *spawn_screen;
+  GdkWindow       *root;
+  Display         *xdisplay;
+
+  if (G_UNLIKELY (xfce_spawn_screen_quark == 0))
+    xfce_spawn_screen_quark = g_quark_from_static_string ("xfce-spawn-screen");
+
+  spawn_screen = g_object_get_qdata (G_OBJECT (screen), xfce_spawn_screen_quark);
+  if (G_LIKELY (spawn_screen != NULL))
+    return spawn_screen;
+
+  root = gdk_screen_get_root_window (screen);
+  xdisplay = GDK_SCREEN_XDISPLAY (screen);
+
+  spawn_screen = g_slice_new0 (XfceSpawnScreen);
+  spawn_screen->screen = screen;
+
+  /* one display connection for all startup sequences */
+  spawn_screen->sn_display = sn_display_new (xdisplay,
+                                             (SnDisplayErrorTrapPush) gdk_error_trap_push,
+                                             (SnDisplayErrorTrapPop) gdk_error_trap_pop);
+
+  spawn_screen->pending = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  if (G_LIKELY (spawn_screen->sn_display != NULL))
+    spawn_screen->sn_monitor = sn_monitor_context_new (spawn_screen->sn_display,
+                                                       GDK_SCREEN_XNUMBER (screen),
+                                                       xfce_spawn_monitor_event,
+                                                       spawn_screen, NULL);
+
+  /* determine the X atom values */
+  spawn_screen->net_current_desktop = XInternAtom (xdisplay, "_NET_CURRENT_DESKTOP", False);
+  spawn_screen->win_workspace = XInternAtom (xdisplay, "_WIN_WORKSPACE", False);
+
+  /* track the active workspace */
+  gdk_window_set_events (root, gdk_window_get_events (root) | GDK_PROPERTY_CHANGE_MASK);
+  gdk_window_add_filter (root, xfce_spawn_root_filter, spawn_screen);
+  spawn_screen->workspace = xfce_spawn_read_workspace_number (spawn_screen);
+
+  g_object_set_qdata_full (G_OBJECT (screen), xfce_spawn_screen_quark,
+                           spawn_screen, xfce_spawn_screen_free);
+
+  return spawn_screen;
+}
+
+
+
 GdkScreen *
 xfce_gdk_screen_get_active (gint *monitor_return)
 {
@@ -256,130 +533,47 @@ xfce_gdk_screen_get_active (gint *monitor_return)
 
 
 
-/**
- * xfce_spawn_on_screen_with_closure:
- * @screen              : a #GdkScreen or %NULL to use the active screen,
- *                        see xfce_gdk_screen_get_active().
- * @working_directory   : child's current working directory or %NULL to
- *                        inherit parent's.
- * @argv                : child's argument vector.
- * @envp                : child's environment vector or %NULL to inherit
- *                        parent's.
- * @flags               : flags from #GSpawnFlags. #G_SPAWN_DO_NOT_REAP_CHILD
- *                        is not allowed, you should use the
- *                        @child_watch_closure for this.
- * @startup_notify      : whether to use startup notification.
- * @startup_timestamp   : the timestamp to pass to startup notification, use
- *                        the event time here if possible to make focus
- *                        stealing prevention work property. If you don't
- *                        have direct access to the event time you could use
- *                        gtk_get_current_event_time() or if nothing is
- *                        available 0 is valid too.
- * @startup_icon_name   : application icon or %NULL.
- * @child_watch_closure : closure that is triggered when the child exists
- *                        or %NULL.
- * @error               : return location for errors or %NULL.
- *
- * Like xfce_spawn_on_screen(), but allows to attach a closure to watch the
- * child's exit status. This because only one g_child_watch_add() is allowed on
- * Unix (per PID) and this is already internally needed for a proper
- * startup notification implementation.
- *
- * <example>
- * <title>Spawning with a child watch</title>
- * <programlisting>
- * static void
- * child_watch_callback (GObject *object,
- *                       gint     status)
- * {
- *   g_message ("Child exit status is %d", status);
- * }
- *
- * static void
- * spawn_something (void)
- * {
- *   GClosure *child_watch;
- *
- *   child_watch = g_cclosure_new_swap (G_CALLBACK (child_watch_callback),
- *                                      object, NULL);
- *   xfce_spawn_on_screen_with_child_watch (...,
- *                                          child_watch,
- *                                          ...);
- * }
- * </programlisting>
- * </example>
- *
- * Return value: %TRUE on success, %FALSE if @error is set.
- **/
-gboolean
-xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
-                                       const gchar  *working_directory,
-                                       gchar       **argv,
-                                       gchar       **envp,
-                                       GSpawnFlags   flags,
-                                       gboolean      startup_notify,
-                                       guint32       startup_timestamp,
-                                       const gchar  *startup_icon_name,
-                                       GClosure     *child_watch_closure,
-                                       GError      **error)
+static gboolean
+xfce_spawn_with_env (GdkScreen    *screen,
+                     gchar       **cenvp,
+                     guint         startup_id_slot,
+                     const gchar  *working_directory,
+                     gchar       **argv,
+                     GSpawnFlags   flags,
+                     gboolean      startup_notify,
+                     guint32       startup_timestamp,
+                     const gchar  *startup_icon_name,
+                     const gchar  *application_id,
+                     gint64        request_time,
+                     GClosure     *child_watch_closure,
+                     GError      **error)
 {
   gboolean            succeed;
-  gchar             **cenvp;
-  guint               n;
-  guint               n_cenvp;
-  gchar              *display_name;
   GPid                pid;
   XfceSpawnData      *spawn_data;
   SnLauncherContext  *sn_launcher = NULL;
-  SnDisplay          *sn_display = NULL;
-  gint                sn_workspace;
+  XfceSpawnScreen    *spawn_screen = NULL;
   const gchar        *startup_id;
   const gchar        *prgname;
 
-  g_return_val_if_fail (screen == NULL || GDK_IS_SCREEN (screen), FALSE);
-  g_return_val_if_fail ((flags & G_SPAWN_DO_NOT_REAP_CHILD) == 0, FALSE);
-  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-  /* lookup the screen with the pointer */
-  if (screen == NULL)
-    screen = xfce_gdk_screen_get_active (NULL);
-
-  /* setup the child environment (stripping $DESKTOP_STARTUP_ID and $DISPLAY) */
-  if (G_LIKELY (envp == NULL))
-    envp = (gchar **) environ;
-
-  for (n = 0; envp[n] != NULL; ++n);
-  cenvp = g_new0 (gchar *, n + 3);
-  for (n_cenvp = n = 0; envp[n] != NULL; ++n)
-    {
-      if (strncmp (envp[n], "DESKTOP_STARTUP_ID", 18) != 0
-          && strncmp (envp[n], "DISPLAY", 7) != 0)
-        cenvp[n_cenvp++] = g_strdup (envp[n]);
-    }
-
-  /* add the real display name for the screen */
-  display_name = gdk_screen_make_display_name (screen);
-  cenvp[n_cenvp++] = g_strconcat ("DISPLAY=", display_name, NULL);
-  g_free (display_name);
-
   /* initialize the sn launcher context */
   if (G_LIKELY (startup_notify))
     {
-      sn_display = sn_display_new (GDK_SCREEN_XDISPLAY (screen),
-                                   (SnDisplayErrorTrapPush) gdk_error_trap_push,
-                                   (SnDisplayErrorTrapPop) gdk_error_trap_pop);
+      spawn_screen = xfce_spawn_screen_get (screen);
 
-      if (G_LIKELY (sn_display != NULL))
+      if (G_LIKELY (spawn_screen->sn_display != NULL))
         {
-          sn_launcher = sn_launcher_context_new (sn_display, GDK_SCREEN_XNUMBER (screen));
+          sn_launcher = sn_launcher_context_new (spawn_screen->sn_display,
+                                                 GDK_SCREEN_XNUMBER (screen));
           if (G_LIKELY (sn_launcher != NULL))
             {
               /* initiate the sn launcher context */
-              sn_workspace = xfce_spawn_get_active_workspace_number (screen);
-              sn_launcher_context_set_workspace (sn_launcher, sn_workspace);
+              sn_launcher_context_set_workspace (sn_launcher, spawn_screen->workspace);
               sn_launcher_context_set_binary_name (sn_launcher, argv[0]);
               sn_launcher_context_set_icon_name (sn_launcher, startup_icon_name != NULL ?
                                                  startup_icon_name : "applications-other");
+              if (application_id != NULL)
+                sn_launcher_context_set_application_id (sn_launcher, application_id);
 
               if (G_LIKELY (!sn_launcher_context_get_initiated (sn_launcher)))
                 {
@@ -392,7 +586,7 @@ xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
               /* add the real startup id to the child environment */
               startup_id = sn_launcher_context_get_startup_id (sn_launcher);
               if (G_LIKELY (startup_id != NULL))
-                cenvp[n_cenvp++] = g_strconcat ("DESKTOP_STARTUP_ID=", startup_id, NULL);
+                cenvp[startup_id_slot] = g_strconcat ("DESKTOP_STARTUP_ID=", startup_id, NULL);
             }
         }
     }
@@ -415,16 +609,22 @@ xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
     }
 
   /* try to spawn the new process */
-  succeed = g_spawn_async (working_directory, argv, cenvp, flags, NULL,
-                           NULL, &pid, error);
+  succeed = applauncher_spawn_async (working_directory, argv, cenvp, flags,
+                                     &pid, error);
 
-  g_strfreev (cenvp);
+  /* clear the startup id slot again */
+  g_free (cenvp[startup_id_slot]);
+  cenvp[startup_id_slot] = NULL;
 
   if (G_LIKELY (succeed))
     {
       /* setup data to watch the child */
       spawn_data = g_slice_new0 (XfceSpawnData);
       spawn_data->pid = pid;
+      spawn_data->spawn_screen = spawn_screen;
+      spawn_data->exec_time = g_get_monotonic_time ();
+      spawn_data->request_time = request_time != 0 ? request_time : spawn_data->exec_time;
+      spawn_data->application_id = g_strdup (application_id);
       if (child_watch_closure != NULL)
         {
           spawn_data->closure = g_closure_ref (child_watch_closure);
@@ -442,12 +642,21 @@ xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
            * a certain about of time, to handle applications that do not
            * properly implement startup notify */
           spawn_data->sn_launcher = sn_launcher;
+          if (spawn_data->application_id != NULL)
+            g_hash_table_insert (spawn_screen->pending,
+                                 g_strdup (sn_launcher_context_get_startup_id (sn_launcher)),
+                                 spawn_data);
           spawn_data->timeout_id = g_timeout_add_seconds_full (G_PRIORITY_LOW,
                                                                XFCE_SPAWN_STARTUP_TIMEOUT,
                                                                xfce_spawn_startup_timeout,
                                                                spawn_data,
                                                                xfce_spawn_startup_timeout_destroy);
         }
+      else
+        {
+          /* nothing tells when it is ready */
+          xfce_spawn_record_launch (spawn_data, -1);
+        }
     }
   else
     {
@@ -459,10 +668,6 @@ xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
         }
     }
 
-  /* release the sn display */
-  if (G_LIKELY (sn_display != NULL))
-    sn_display_unref (sn_display);
-
   return succeed;
 
 return FALSE;
@@ -470,6 +675,251 @@ return FALSE;
 
 
 
+static gboolean
+xfce_spawn_on_screen_internal (GdkScreen    *screen,
+                               const gchar  *working_directory,
+                               gchar       **argv,
+                               gchar       **envp,
+                               GSpawnFlags   flags,
+                               gboolean      startup_notify,
+                               guint32       startup_timestamp,
+                               const gchar  *startup_icon_name,
+                               const gchar  *application_id,
+                               gint64        request_time,
+                               GClosure     *child_watch_closure,
+                               GError      **error)
+{
+  gboolean            succeed;
+  gchar             **cenvp;
+  guint               startup_id_slot;
+
+  g_return_val_if_fail (screen == NULL || GDK_IS_SCREEN (screen), FALSE);
+  g_return_val_if_fail ((flags & G_SPAWN_DO_NOT_REAP_CHILD) == 0, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /* lookup the screen with the pointer */
+  if (screen == NULL)
+    screen = xfce_gdk_screen_get_active (NULL);
+
+  /* inheriting the panel's environment uses the cached template of the screen */
+  if (G_LIKELY (envp == NULL))
+    {
+      XfceSpawnEnv *env = xfce_spawn_env_get (screen);
+
+      return xfce_spawn_with_env (screen, env->envp, env->startup_id_slot,
+                                  working_directory, argv, flags, startup_notify,
+                                  startup_timestamp, startup_icon_name,
+                                  application_id, request_time,
+                                  child_watch_closure, error);
+    }
+
+  cenvp = xfce_spawn_env_build (envp, screen, &startup_id_slot);
+  succeed = xfce_spawn_with_env (screen, cenvp, startup_id_slot,
+                                 working_directory, argv, flags, startup_notify,
+                                 startup_timestamp, startup_icon_name,
+                                 application_id, request_time,
+                                 child_watch_closure, error);
+  g_strfreev (cenvp);
+
+  return succeed;
+}
+
+
+
+/**
+ * xfce_spawn_on_screen_with_closure:
+ * @screen              : a #GdkScreen or %NULL to use the active screen,
+ *                        see xfce_gdk_screen_get_active().
+ * @working_directory   : child's current working directory or %NULL to
+ *                        inherit parent's.
+ * @argv                : child's argument vector.
+ * @envp                : child's environment vector or %NULL to inherit
+ *                        parent's.
+ * @flags               : flags from #GSpawnFlags. #G_SPAWN_DO_NOT_REAP_CHILD
+ *                        is not allowed, you should use the
+ *                        @child_watch_closure for this.
+ * @startup_notify      : whether to use startup notification.
+ * @startup_timestamp   : the timestamp to pass to startup notification, use
+ *                        the event time here if possible to make focus
+ *                        stealing prevention work property. If you don't
+ *                        have direct access to the event time you could use
+ *                        gtk_get_current_event_time() or if nothing is
+ *                        available 0 is valid too.
+ * @startup_icon_name   : application icon or %NULL.
+ * @child_watch_closure : closure that is triggered when the child exists
+ *                        or %NULL.
+ * @error               : return location for errors or %NULL.
+ *
+ * Like xfce_spawn_on_screen(), but allows to attach a closure to watch the
+ * child's exit status. This because only one g_child_watch_add() is allowed on
+ * Unix (per PID) and this is already internally needed for a proper
+ * startup notification implementation.
+ *
+ * <example>
+ * <title>Spawning with a child watch</title>
+ * <programlisting>
+ * static void
+ * child_watch_callback (GObject *object,
+ *                       gint     status)
+ * {
+ *   g_message ("Child exit status is %d", status);
+ * }
+ *
+ * static void
+ * spawn_something (void)
+ * {
+ *   GClosure *child_watch;
+ *
+ *   child_watch = g_cclosure_new_swap (G_CALLBACK (child_watch_callback),
+ *                                      object, NULL);
+ *   xfce_spawn_on_screen_with_child_watch (...,
+ *                                          child_watch,
+ *                                          ...);
+ * }
+ * </programlisting>
+ * </example>
+ *
+ * Return value: %TRUE on success, %FALSE if @error is set.
+ **/
+gboolean
+xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
+                                       const gchar  *working_directory,
+                                       gchar       **argv,
+                                       gchar       **envp,
+                                       GSpawnFlags   flags,
+                                       gboolean      startup_notify,
+                                       guint32       startup_timestamp,
+                                       const gchar  *startup_icon_name,
+                                       GClosure     *child_watch_closure,
+                                       GError      **error)
+{
+  return xfce_spawn_on_screen_internal (screen, working_directory, argv, envp,
+                                        flags, startup_notify, startup_timestamp,
+                                        startup_icon_name, NULL, 0,
+                                        child_watch_closure, error);
+}
+
+
+
+/**
+ * xfce_spawn_prepare_screen:
+ * @screen : a #GdkScreen.
+ *
+ * Sets up the startup notification display and the workspace tracking
+ * of @screen ahead of time, so the first launch does not have to talk
+ * to the X server for it.
+ **/
+void
+xfce_spawn_prepare_screen (GdkScreen *screen)
+{
+  g_return_if_fail (GDK_IS_SCREEN (screen));
+
+  xfce_spawn_screen_get (screen);
+}
+
+
+
+/**
+ * xfce_spawn_application_on_screen:
+ * @screen            : a #GdkScreen or %NULL to use the active screen.
+ * @working_directory : child's current working directory or %NULL.
+ * @argv              : child's argument vector.
+ * @startup_timestamp : the timestamp to pass to startup notification.
+ * @startup_icon_name : application icon or %NULL.
+ * @application_id    : desktop id of the application.
+ * @request_time      : g_get_monotonic_time() of the user's request.
+ * @error             : return location for errors or %NULL.
+ *
+ * Like xfce_spawn_on_screen() with startup notification, but also
+ * records in the launch stats of @application_id how long it took
+ * from @request_time to the exec, and from the exec to the end of the
+ * startup sequence.
+ *
+ * Return value: %TRUE on success, %FALSE if @error is set.
+ **/
+gboolean
+xfce_spawn_application_on_screen (GdkScreen    *screen,
+                                  const gchar  *working_directory,
+                                  gchar       **argv,
+                                  guint32       startup_timestamp,
+                                  const gchar  *startup_icon_name,
+                                  const gchar  *application_id,
+                                  gint64        request_time,
+                                  GError      **error)
+{
+  g_return_val_if_fail (application_id != NULL, FALSE);
+
+  return xfce_spawn_on_screen_internal (screen, working_directory, argv, NULL,
+                                        0, TRUE, startup_timestamp,
+                                        startup_icon_name, application_id,
+                                        request_time, NULL, error);
+}
+
+
+
+/**
+ * xfce_spawn_applications_on_screen:
+ * @screen            : a #GdkScreen or %NULL to use the active screen.
+ * @requests          : the applications to spawn.
+ * @n_requests        : number of elements in @requests.
+ * @startup_timestamp : the timestamp to pass to startup notification.
+ * @request_time      : g_get_monotonic_time() of the user's request.
+ * @error             : return location for the first error or %NULL.
+ *
+ * Spawns several applications like xfce_spawn_application_on_screen(),
+ * looking up the environment template and the startup notification
+ * display of @screen only once for the whole batch. A failure does not
+ * stop the remaining requests.
+ *
+ * Return value: %TRUE if all were spawned, %FALSE if @error is set.
+ **/
+gboolean
+xfce_spawn_applications_on_screen (GdkScreen              *screen,
+                                   const XfceSpawnRequest *requests,
+                                   guint                   n_requests,
+                                   guint32                 startup_timestamp,
+                                   gint64                  request_time,
+                                   GError                **error)
+{
+  XfceSpawnEnv *env;
+  GError       *err = NULL;
+  gboolean      succeed = TRUE;
+  guint         n;
+
+  g_return_val_if_fail (screen == NULL || GDK_IS_SCREEN (screen), FALSE);
+  g_return_val_if_fail (requests != NULL || n_requests == 0, FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (screen == NULL)
+    screen = xfce_gdk_screen_get_active (NULL);
+
+  env = xfce_spawn_env_get (screen);
+  xfce_spawn_screen_get (screen);
+
+  for (n = 0; n < n_requests; ++n)
+    {
+      if (!xfce_spawn_with_env (screen, env->envp, env->startup_id_slot,
+                                requests[n].working_directory, requests[n].argv,
+                                0, TRUE, startup_timestamp,
+                                requests[n].startup_icon_name,
+                                requests[n].application_id, request_time,
+                                NULL, &err))
+        {
+          if (succeed)
+            g_propagate_error (error, err);
+          else
+            g_error_free (err);
+
+          err = NULL;
+          succeed = FALSE;
+        }
+    }
+
+  return succeed;
+}
+
+
+
 /**
  * xfce_spawn_on_screen:
  * @screen            : a #GdkScreen or %NULL to use the active screen,
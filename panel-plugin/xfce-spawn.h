@@ -24,6 +24,14 @@
 
 G_BEGIN_DECLS
 
+typedef struct
+{
+  const gchar  *working_directory;
+  gchar       **argv;
+  const gchar  *startup_icon_name;
+  const gchar  *application_id;
+} XfceSpawnRequest;
+
 gboolean xfce_spawn_on_screen_with_child_watch (GdkScreen    *screen,
                                                 const gchar  *working_directory,
                                                 gchar       **argv,
@@ -45,6 +53,24 @@ gboolean xfce_spawn_on_screen                  (GdkScreen    *screen,
                                                 const gchar  *startup_icon_name,
                                                 GError      **error);
 
+gboolean xfce_spawn_application_on_screen      (GdkScreen    *screen,
+                                                const gchar  *working_directory,
+                                                gchar       **argv,
+                                                guint32       startup_timestamp,
+                                                const gchar  *startup_icon_name,
+                                                const gchar  *application_id,
+                                                gint64        request_time,
+                                                GError      **error);
+
+gboolean xfce_spawn_applications_on_screen     (GdkScreen              *screen,
+                                                const XfceSpawnRequest *requests,
+                                                guint                   n_requests,
+                                                guint32                 startup_timestamp,
+                                                gint64                  request_time,
+                                                GError                **error);
+
+void     xfce_spawn_prepare_screen             (GdkScreen    *screen);
+
 
 G_END_DECLS
 